@@ -0,0 +1,264 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <dbus/dbus.h>
+
+//
+// Type traits
+//
+// One specialization per supported C++ type. Using a type without a
+// specialization (or passing a value of the wrong type) fails to compile.
+
+template<typename T>
+struct DBusType;
+
+template<typename T, int Code>
+struct DBusBasicType {
+    static constexpr int code = Code;
+    static constexpr char signature[] = { static_cast<char>(Code), '\0' };
+
+    static void read(DBusMessageIter* iter, T& value) {
+        dbus_message_iter_get_basic(iter, &value);
+    }
+    static bool write(DBusMessageIter* iter, const T& value) {
+        return dbus_message_iter_append_basic(iter, Code, &value);
+    }
+};
+
+template<> struct DBusType<uint8_t>  : DBusBasicType<uint8_t,  DBUS_TYPE_BYTE>   {};
+template<> struct DBusType<int16_t>  : DBusBasicType<int16_t,  DBUS_TYPE_INT16>  {};
+template<> struct DBusType<uint16_t> : DBusBasicType<uint16_t, DBUS_TYPE_UINT16> {};
+template<> struct DBusType<int32_t>  : DBusBasicType<int32_t,  DBUS_TYPE_INT32>  {};
+template<> struct DBusType<uint32_t> : DBusBasicType<uint32_t, DBUS_TYPE_UINT32> {};
+template<> struct DBusType<int64_t>  : DBusBasicType<int64_t,  DBUS_TYPE_INT64>  {};
+template<> struct DBusType<uint64_t> : DBusBasicType<uint64_t, DBUS_TYPE_UINT64> {};
+template<> struct DBusType<double>   : DBusBasicType<double,   DBUS_TYPE_DOUBLE> {};
+
+// b (dbus_bool_t is 32 bit on the wire)
+template<>
+struct DBusType<bool> {
+    static constexpr int code = DBUS_TYPE_BOOLEAN;
+    static constexpr char signature[] = "b";
+
+    static void read(DBusMessageIter* iter, bool& value) {
+        dbus_bool_t raw = FALSE;
+        dbus_message_iter_get_basic(iter, &raw);
+        value = (FALSE != raw);
+    }
+    static bool write(DBusMessageIter* iter, const bool& value) {
+        dbus_bool_t raw = value ? TRUE : FALSE;
+        return dbus_message_iter_append_basic(iter, DBUS_TYPE_BOOLEAN, &raw);
+    }
+};
+
+// s (read: points into the message, valid while the message is alive)
+template<>
+struct DBusType<const char*> {
+    static constexpr int code = DBUS_TYPE_STRING;
+    static constexpr char signature[] = "s";
+
+    static void read(DBusMessageIter* iter, const char*& value) {
+        dbus_message_iter_get_basic(iter, &value);
+    }
+    static bool write(DBusMessageIter* iter, const char* const& value) {
+        return dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, &value);
+    }
+};
+
+// s (read: view into the message, no copy)
+template<>
+struct DBusType<std::string_view> {
+    static constexpr int code = DBUS_TYPE_STRING;
+    static constexpr char signature[] = "s";
+
+    static void read(DBusMessageIter* iter, std::string_view& value) {
+        const char* str = nullptr;
+        dbus_message_iter_get_basic(iter, &str);
+        value = std::string_view(str);
+    }
+    // a view is not guaranteed to be NUL terminated, so it is copied once;
+    // use const char* / std::string on hot write paths
+    static bool write(DBusMessageIter* iter, const std::string_view& value) {
+        const std::string copy(value);
+        const char* str = copy.c_str();
+        return dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, &str);
+    }
+};
+
+// s (read: copies)
+template<>
+struct DBusType<std::string> {
+    static constexpr int code = DBUS_TYPE_STRING;
+    static constexpr char signature[] = "s";
+
+    static void read(DBusMessageIter* iter, std::string& value) {
+        const char* str = nullptr;
+        dbus_message_iter_get_basic(iter, &str);
+        value.assign(str);
+    }
+    static bool write(DBusMessageIter* iter, const std::string& value) {
+        const char* str = value.c_str();
+        return dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, &str);
+    }
+};
+
+// s (read: copies into the string's own allocator, e.g. a request arena)
+template<>
+struct DBusType<std::pmr::string> {
+    static constexpr int code = DBUS_TYPE_STRING;
+    static constexpr char signature[] = "s";
+
+    static void read(DBusMessageIter* iter, std::pmr::string& value) {
+        const char* str = nullptr;
+        dbus_message_iter_get_basic(iter, &str);
+        value.assign(str);
+    }
+    static bool write(DBusMessageIter* iter, const std::pmr::string& value) {
+        const char* str = value.c_str();
+        return dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, &str);
+    }
+};
+
+// h (file descriptor)
+// read: libdbus hands out a new duplicate, the caller must close it.
+// write: the message keeps its own duplicate, the caller still owns fd.
+struct DBusUnixFd {
+    int fd = -1;
+};
+
+template<>
+struct DBusType<DBusUnixFd> {
+    static constexpr int code = DBUS_TYPE_UNIX_FD;
+    static constexpr char signature[] = "h";
+
+    static void read(DBusMessageIter* iter, DBusUnixFd& value) {
+        dbus_message_iter_get_basic(iter, &(value.fd));
+    }
+    static bool write(DBusMessageIter* iter, const DBusUnixFd& value) {
+        return dbus_message_iter_append_basic(iter, DBUS_TYPE_UNIX_FD, &(value.fd));
+    }
+};
+
+// a<fixed> (read: view into the message, no copy; valid while the message
+// is alive. write: one block copy). Element types: the fixed-size numeric
+// DBusBasicType specializations (y, n, q, i, u, x, t, d).
+
+template<typename T>
+struct DBusFixedArray {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    const T& operator[](size_t i) const { return data[i]; }
+};
+
+template<typename T>
+struct DBusType<DBusFixedArray<T>> {
+    // bool is 1 byte here but 4 bytes (dbus_bool_t) on the wire
+    static_assert(std::is_arithmetic_v<T> && false == std::is_same_v<T, bool>, "fixed arrays hold numbers only");
+
+    static constexpr int code = DBUS_TYPE_ARRAY;
+    static constexpr char signature[] = { 'a', static_cast<char>(DBusType<T>::code), '\0' };
+
+    static void read(DBusMessageIter* iter, DBusFixedArray<T>& value) {
+        DBusMessageIter sub;
+        int count = 0;
+        dbus_message_iter_recurse(iter, &sub);
+        dbus_message_iter_get_fixed_array(&sub, &(value.data), &count);
+        value.size = static_cast<size_t>(count);
+    }
+    static bool write(DBusMessageIter* iter, const DBusFixedArray<T>& value) {
+        DBusMessageIter sub;
+        const T* data = value.data;
+        if ( false == dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, signature + 1, &sub) ) {
+            return false;
+        }
+        if ( false == dbus_message_iter_append_fixed_array(&sub, DBusType<T>::code, &data, static_cast<int>(value.size)) ) {
+            dbus_message_iter_abandon_container(iter, &sub);
+            return false;
+        }
+        return dbus_message_iter_close_container(iter, &sub);
+    }
+};
+
+//
+// Signature
+//
+// Built at compile time by concatenating each type's signature.
+
+template<typename... Ts>
+struct DBusSignature {
+private:
+    static constexpr size_t length = (size_t(0) + ... + (sizeof(DBusType<Ts>::signature) - 1));
+
+    static constexpr std::array<char, length + 1> make() {
+        std::array<char, length + 1> out{};
+        size_t pos = 0;
+        auto append = [&out, &pos] (const char* part) {
+            while (*part) {
+                out[pos++] = *part++;
+            }
+        };
+        (append(DBusType<Ts>::signature), ...);
+        out[pos] = '\0';
+        return out;
+    }
+
+public:
+    static constexpr std::array<char, length + 1> value = make();
+
+    static constexpr const char* c_str() {
+        return value.data();
+    }
+};
+
+//
+// Arguments
+//
+// DBusArgs<int32_t, double, std::string_view>::read(message, a, b, c)
+// DBusArgs<int32_t>::append(reply, result)
+//
+// read() checks the whole signature with one string compare, then pulls
+// each value with a direct iterator call (no varargs type parsing).
+
+template<typename... Ts>
+struct DBusArgs {
+    static constexpr const char* signature() {
+        return DBusSignature<Ts...>::c_str();
+    }
+
+    // false if the message signature does not match exactly
+    static bool read(DBusMessage* message, Ts&... values) {
+        if ( false == dbus_message_has_signature(message, DBusArgs::signature()) ) {
+            return false;
+        }
+
+        DBusMessageIter iter;
+        if ( false == dbus_message_iter_init(message, &iter) ) {
+            return (0 == sizeof...(Ts));
+        }
+        (DBusArgs::readOne(&iter, values), ...);
+        return true;
+    }
+
+    // false if libdbus runs out of memory
+    static bool append(DBusMessage* message, const Ts&... values) {
+        DBusMessageIter iter;
+        dbus_message_iter_init_append(message, &iter);
+        return (true && ... && (FALSE != DBusType<Ts>::write(&iter, values)));
+    }
+
+private:
+    template<typename T>
+    static void readOne(DBusMessageIter* iter, T& value) {
+        DBusType<T>::read(iter, value);
+        dbus_message_iter_next(iter);
+    }
+};
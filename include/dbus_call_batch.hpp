@@ -0,0 +1,308 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <dbus/dbus.h>
+
+#include "dbus_dispatcher.hpp"
+
+//
+// Call Batch
+//
+// Many method calls for about the price of one round trip. add() builds
+// each call up front; run() queues all of them on the connection, then one
+// read / write loop flushes them and collects the replies in whatever order
+// they come, under a single overall timeout. Results keep the order of
+// add(): each holds the reply or the error (remote error, or NoReply for a
+// call still open when the time is up). Parse callbacks then run in order.
+//
+//   DBusCallBatch batch(conn);
+//   for (...) { batch.add(service, path, interface, "Add", appendArgs, parseFunc); }
+//   batch.run(1000);
+//
+// With a dispatcher (thread-safe mode) the calls go through its I/O thread.
+
+class DBusCallBatch {
+public:
+    struct Result {
+        // Method return (owned by the batch), nullptr on error
+        DBusMessage* reply;
+        std::string error_name;
+        std::string error_message;
+
+        bool ok() const { return nullptr != reply; }
+    };
+
+private:
+    struct Call {
+        DBusCallBatch* batch;
+        size_t index;
+        DBusMessage* message;
+        DBusPendingCall* pending;
+        bool answered;
+        std::function<void(DBusMessage*)> parseFunc;
+    };
+
+private:
+    DBusConnection* conn;
+    DBusDispatcher* dispatcher;
+    std::vector<Call> calls;
+    std::vector<Result> result_list;
+    size_t remaining;
+private:
+    // Dispatcher completions arrive on its I/O thread
+    std::mutex mutex;
+    std::condition_variable all_done;
+
+public:
+    // Constructor
+    explicit DBusCallBatch(DBusConnection* dc, DBusDispatcher* call_dispatcher = nullptr) :
+        conn(dc),
+        dispatcher(call_dispatcher),
+        remaining(0)
+    {}
+    // delete
+    DBusCallBatch() = delete;
+    DBusCallBatch(DBusCallBatch&& other) = delete;
+    DBusCallBatch& operator=(DBusCallBatch&& other) = delete;
+    DBusCallBatch(const DBusCallBatch&) = delete;
+    DBusCallBatch& operator=(const DBusCallBatch&) = delete;
+    // De-Constructor
+    ~DBusCallBatch() {
+        this->DBusCallBatch::clear();
+    }
+
+public:
+    // Queue one call (nothing is sent yet); returns its index in results()
+    size_t add(
+        const char* service_name,
+        const char* object_path,
+        const char* interface_name,
+        const char* method_name,
+        const std::function<bool(DBusMessage*)>& appendArgs = nullptr,
+        const std::function<void(DBusMessage*)>& parseFunc = nullptr)
+    {
+        const size_t index = this->calls.size();
+        this->calls.push_back(Call{ this, index, nullptr, nullptr, false, parseFunc });
+        this->result_list.push_back(Result{ nullptr, std::string(), std::string() });
+
+        DBusMessage* method_call = nullptr;
+        if ( nullptr ==
+            (method_call = dbus_message_new_method_call(
+                service_name,
+                object_path,
+                interface_name,
+                method_name)
+            ) ) {
+            this->DBusCallBatch::setError(index, DBUS_ERROR_NO_MEMORY, "Unable to allocate memory for the message");
+            return index;
+        }
+        if (appendArgs && false == appendArgs(method_call)) {
+            dbus_message_unref(method_call);
+            this->DBusCallBatch::setError(index, DBUS_ERROR_INVALID_ARGS, "Unable to append arguments");
+            return index;
+        }
+        this->calls[index].message = method_call;
+        return index;
+    }
+
+    // Send every queued call and wait for all replies, at most timeout_ms in
+    // total (-1: libdbus default); true if every call succeeded
+    bool run(int timeout_ms = DBUS_TIMEOUT_USE_DEFAULT) {
+        if (timeout_ms < 0) {
+            timeout_ms = DBusDispatcher::kDefaultTimeoutMs;
+        }
+
+        if (this->dispatcher) {
+            this->DBusCallBatch::runThroughDispatcher(timeout_ms);
+        }
+        else {
+            this->DBusCallBatch::runOnConnection(timeout_ms);
+        }
+
+        // Parse in request order
+        bool all_ok = true;
+        for (Call& call : this->calls) {
+            const Result& result = this->result_list[call.index];
+            if (false == result.ok()) {
+                all_ok = false;
+                continue;
+            }
+            if (call.parseFunc) {
+                call.parseFunc(result.reply);
+                call.parseFunc = nullptr;
+            }
+        }
+        return all_ok;
+    }
+
+    // One entry per add(), in the same order
+    const std::vector<Result>& results() const {
+        return this->result_list;
+    }
+
+    size_t size() const {
+        return this->calls.size();
+    }
+
+    // Drop every call and result (the batch can be filled again)
+    void clear() {
+        for (Call& call : this->calls) {
+            if (call.pending) {
+                dbus_pending_call_cancel(call.pending);
+                dbus_pending_call_unref(call.pending);
+            }
+            if (call.message) {
+                dbus_message_unref(call.message);
+            }
+        }
+        for (Result& result : this->result_list) {
+            if (result.reply) {
+                dbus_message_unref(result.reply);
+            }
+        }
+        this->calls.clear();
+        this->result_list.clear();
+    }
+
+private:
+    void runOnConnection(int timeout_ms) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+        // Queue everything first. No per-call timer: the deadline below covers all calls
+        this->remaining = 0;
+        for (Call& call : this->calls) {
+            if (nullptr == call.message || call.answered) {
+                continue;
+            }
+            if ( nullptr == this->conn
+                || false == dbus_connection_send_with_reply(this->conn, call.message, &(call.pending), DBUS_TIMEOUT_INFINITE)
+                || nullptr == call.pending ) {
+                this->DBusCallBatch::setError(call.index, DBUS_ERROR_DISCONNECTED, "Unable to send the message");
+                continue;
+            }
+            if ( false == dbus_pending_call_set_notify(call.pending, DBusCallBatch::onPendingCallNotify, &call, nullptr) ) {
+                dbus_pending_call_cancel(call.pending);
+                dbus_pending_call_unref(call.pending);
+                call.pending = nullptr;
+                this->DBusCallBatch::setError(call.index, DBUS_ERROR_NO_MEMORY, "Unable to allocate memory");
+                continue;
+            }
+            ++(this->remaining);
+        }
+
+        // The sends wrote what the socket took at once; the first iteration
+        // flushes the rest, later ones read replies until all are in
+        while (this->remaining > 0) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) {
+                break;
+            }
+            if ( false == dbus_connection_read_write_dispatch(this->conn, static_cast<int>(left)) ) {
+                std::cerr << "ERROR: dbus_connection_read_write_dispatch - Connection closed with "
+                          << this->remaining << " call(s) pending!" << std::endl;
+                break;
+            }
+        }
+
+        for (Call& call : this->calls) {
+            if (call.pending) {
+                if (false == call.answered) {
+                    dbus_pending_call_cancel(call.pending);
+                    this->DBusCallBatch::setError(call.index, DBUS_ERROR_NO_REPLY, "Did not receive a reply before the batch timeout");
+                }
+                dbus_pending_call_unref(call.pending);
+                call.pending = nullptr;
+            }
+            this->DBusCallBatch::releaseMessage(call);
+        }
+    }
+
+    void runThroughDispatcher(int timeout_ms) {
+        // Count first: completions may start before the last send
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->remaining = 0;
+            for (const Call& call : this->calls) {
+                if (call.message && false == call.answered) {
+                    ++(this->remaining);
+                }
+            }
+        }
+
+        // The dispatcher fails every call after timeout_ms, so the wait below is bounded
+        for (Call& call : this->calls) {
+            if (nullptr == call.message || call.answered) {
+                continue;
+            }
+            const size_t index = call.index;
+            const bool sent = this->dispatcher->send(call.message, timeout_ms, [this, index] (DBusMessage* reply) {
+                this->DBusCallBatch::onDispatched(index, reply ? dbus_message_ref(reply) : nullptr);
+            });
+            if (false == sent) {
+                this->DBusCallBatch::onDispatched(index, nullptr);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->all_done.wait(lock, [this] () { return 0 == this->remaining; });
+        lock.unlock();
+
+        for (Call& call : this->calls) {
+            this->DBusCallBatch::releaseMessage(call);
+        }
+    }
+
+    static void onPendingCallNotify(DBusPendingCall* pending, void* user_data) {
+        Call* call = static_cast<Call*>(user_data);
+        call->batch->DBusCallBatch::complete(*call, dbus_pending_call_steal_reply(pending));
+        --(call->batch->remaining);
+    }
+
+    // Dispatcher I/O thread
+    void onDispatched(size_t index, DBusMessage* reply) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->DBusCallBatch::complete(this->calls[index], reply);
+        if (0 == --(this->remaining)) {
+            this->all_done.notify_all();
+        }
+    }
+
+    // Store the reply (takes ownership) or its error
+    void complete(Call& call, DBusMessage* reply) {
+        call.answered = true;
+        if (nullptr == reply) {
+            this->DBusCallBatch::setError(call.index, DBUS_ERROR_DISCONNECTED, "Unable to send the message");
+            return;
+        }
+
+        DBusError error;
+        dbus_error_init(&error);
+        if ( true == dbus_set_error_from_message(&error, reply) ) {
+            this->DBusCallBatch::setError(call.index, error.name, error.message);
+            dbus_error_free(&error);
+            dbus_message_unref(reply);
+            return;
+        }
+        this->result_list[call.index].reply = reply;
+    }
+
+    void setError(size_t index, const char* name, const char* message) {
+        this->calls[index].answered = true;
+        this->result_list[index].error_name = name;
+        this->result_list[index].error_message = message ? message : "";
+    }
+
+    // A sent message cannot be sent again: the batch is spent
+    static void releaseMessage(Call& call) {
+        if (call.message) {
+            dbus_message_unref(call.message);
+            call.message = nullptr;
+        }
+    }
+};
@@ -1,9 +1,17 @@
 #pragma once
 
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <dbus/dbus.h>
 
+#include "dbus_dispatcher.hpp"
+
 //
 // Interface
 //
@@ -19,6 +27,15 @@ protected:
         const std::function<bool(DBusMessage*)>& appendArgs,
         const std::function<void(DBusMessage*)>& parseFunc)
         = 0;
+    // Call method without blocking (reply is handled when pending calls are dispatched)
+    virtual std::future<bool> callMethodAsync(
+        const char* service_name,
+        const char* object_path,
+        const char* interface_name,
+        const char* method_name,
+        const std::function<bool(DBusMessage*)>& appendArgs,
+        const std::function<void(DBusMessage*)>& parseFunc)
+        = 0;
 };
 
 //
@@ -27,13 +44,22 @@ protected:
 
 class DBusClient : public IDBusClient {
 protected:
+    // For parsers of subclasses (callMethod uses its own, see below)
     DBusError error;
 protected:
     DBusConnection* conn;
+    // Thread-safe mode: calls go through the dispatcher's I/O thread
+    DBusDispatcher* dispatcher;
+protected:
+    // Number of async calls still waiting for a reply
+    std::atomic<size_t> pending_calls;
+    // Thread-safe mode: signalled when pending_calls drops to 0
+    std::mutex pending_mutex;
+    std::condition_variable pending_done;
 
 public:
     // Constructor
-    DBusClient(DBusConnection* dc): conn(dc)
+    DBusClient(DBusConnection* dc): conn(dc), dispatcher(nullptr), pending_calls(0)
     {
         dbus_error_init(&error);
     }
@@ -47,6 +73,14 @@ public:
         dbus_error_free(&error);
     }
 
+public:
+    // Route every call through a dispatcher that owns this client's connection
+    // (nullptr: back to direct calls). The client may then be shared by any
+    // number of threads; async parse callbacks run on the dispatcher thread.
+    void setDispatcher(DBusDispatcher* call_dispatcher) {
+        this->dispatcher = call_dispatcher;
+    }
+
 protected:
     void callMethod(
         const char* service_name,
@@ -62,11 +96,9 @@ protected:
             return;
         }
 
-        // dbus_connection_send_with_reply_and_block() requires a clean DBusError.
-        if (dbus_error_is_set(&(this->error))) {
-            dbus_error_free(&(this->error));
-        }
-        dbus_error_init(&(this->error));
+        // Per call (not a member): calls may run on several threads at once
+        DBusError call_error;
+        dbus_error_init(&call_error);
 
         // Initialize here to avoid cross creation (related to goto)
         DBusMessage* method_call = nullptr;
@@ -91,16 +123,27 @@ protected:
             }
         }
 
-        // Send method call
-        if ( nullptr ==
+        // Send method call (through the I/O thread in thread-safe mode)
+        if (this->dispatcher) {
+            if ( nullptr == (reply = this->dispatcher->call(method_call, DBUS_TIMEOUT_USE_DEFAULT)) ) {
+                std::cerr << "ERROR: DBusDispatcher - Unable to send the message!" << std::endl;
+                goto UNREF_REPLY;
+            }
+            if ( true == dbus_set_error_from_message(&call_error, reply) ) {
+                std::cerr << call_error.name << std::endl << call_error.message << std::endl;
+                dbus_error_free(&call_error);
+                goto UNREF_REPLY;
+            }
+        }
+        else if ( nullptr ==
             (reply = dbus_connection_send_with_reply_and_block(
                 this->conn,
                 method_call,
                 DBUS_TIMEOUT_USE_DEFAULT,
-                &(this->error))
+                &call_error)
             ) ) {
-            std::cerr << error.name << std::endl << error.message << std::endl;
-            dbus_error_free(&(this->error));
+            std::cerr << call_error.name << std::endl << call_error.message << std::endl;
+            dbus_error_free(&call_error);
             goto UNREF_REPLY;
         }
 
@@ -119,4 +162,234 @@ UNREF_METHOD:
             dbus_message_unref(method_call);
         }
     }
+public:
+    // Number of async calls still in flight
+    size_t pendingCalls() const {
+        return this->pending_calls;
+    }
+
+    // Pump the connection until every async call has been completed
+    // (replies are only processed while somebody dispatches the connection)
+    // timeout_ms: -1 waits forever; returns false if calls are still pending
+    bool waitPending(int timeout_ms = -1) {
+        // Connection
+        if (! this->conn) {
+            return (0 == this->pending_calls);
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+        // The dispatcher thread completes the calls: only wait here. Check
+        // under the lock too, so the last completion is done with this
+        // client before the caller may destroy it.
+        if (this->dispatcher) {
+            std::unique_lock<std::mutex> lock(this->pending_mutex);
+            const auto idle = [this] () { return 0 == this->pending_calls; };
+            if (timeout_ms < 0) {
+                this->pending_done.wait(lock, idle);
+                return true;
+            }
+            return this->pending_done.wait_until(lock, deadline, idle);
+        }
+
+        while (this->pending_calls > 0) {
+            int slice = -1;
+            if (timeout_ms >= 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (left <= 0) {
+                    return false;
+                }
+                slice = static_cast<int>(left);
+            }
+
+            if ( false == dbus_connection_read_write_dispatch(this->conn, slice) ) {
+                std::cerr << "ERROR: dbus_connection_read_write_dispatch - Connection closed with "
+                          << this->pending_calls << " call(s) pending!" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+protected:
+    std::future<bool> callMethodAsync(
+        const char* service_name,
+        const char* object_path,
+        const char* interface_name,
+        const char* method_name,
+        const std::function<bool(DBusMessage*)>& appendArgs,
+        const std::function<void(DBusMessage*)>& parseFunc)
+        override
+    {
+        // Keep parser and promise alive until the reply arrives
+        PendingContext* context = new PendingContext{ this, parseFunc, std::promise<bool>() };
+        std::future<bool> result = context->promise.get_future();
+
+        // Thread-safe mode
+        if (this->dispatcher) {
+            this->DBusClient::sendThroughDispatcher(
+                context, service_name, object_path, interface_name, method_name, appendArgs);
+            return result;
+        }
+
+        // Initialize here to avoid cross creation (related to goto)
+        DBusMessage* method_call = nullptr;
+        DBusPendingCall* pending = nullptr;
+
+        // Connection
+        if (! this->conn) {
+            goto FAIL;
+        }
+
+        // Compose remote procedure call
+        if ( nullptr ==
+            (method_call = dbus_message_new_method_call(
+                service_name,
+                object_path,
+                interface_name,
+                method_name)
+            ) ) {
+            std::cerr << "ERROR: dbus_message_new_method_call - Unable to allocate memory for the message!" << std::endl;
+            goto FAIL;
+        }
+
+        // Append arguments
+        if (appendArgs) {
+            if ( false == appendArgs(method_call) ) {
+                goto FAIL;
+            }
+        }
+
+        // Queue method call (no round trip here)
+        if ( false == dbus_connection_send_with_reply(
+                this->conn,
+                method_call,
+                &pending,
+                DBUS_TIMEOUT_USE_DEFAULT)
+            || nullptr == pending ) {
+            std::cerr << "ERROR: dbus_connection_send_with_reply - Unable to send the message!" << std::endl;
+            goto FAIL;
+        }
+
+        // Hand over context to the pending call (freed by libdbus)
+        if ( false == dbus_pending_call_set_notify(
+                pending,
+                DBusClient::onPendingCallNotify,
+                context,
+                DBusClient::freePendingContext)
+            ) {
+            std::cerr << "ERROR: dbus_pending_call_set_notify - Unable to allocate memory!" << std::endl;
+            dbus_pending_call_cancel(pending);
+            dbus_pending_call_unref(pending);
+            goto FAIL;
+        }
+        ++(this->pending_calls);
+
+        // Release (the connection holds its own reference on the pending call)
+        dbus_pending_call_unref(pending);
+        dbus_message_unref(method_call);
+        return result;
+
+FAIL:
+        if (method_call) {
+            dbus_message_unref(method_call);
+        }
+        context->promise.set_value(false);
+        delete context;
+        return result;
+    }
+
+private:
+    struct PendingContext {
+        DBusClient* client;
+        std::function<void(DBusMessage*)> parseFunc;
+        std::promise<bool> promise;
+    };
+
+    // callMethodAsync() in thread-safe mode (takes over the context)
+    void sendThroughDispatcher(
+        PendingContext* context,
+        const char* service_name,
+        const char* object_path,
+        const char* interface_name,
+        const char* method_name,
+        const std::function<bool(DBusMessage*)>& appendArgs)
+    {
+        // Shared by the completion, which may be copied
+        std::shared_ptr<PendingContext> shared(context);
+
+        DBusMessage* method_call = nullptr;
+        if ( nullptr ==
+            (method_call = dbus_message_new_method_call(
+                service_name,
+                object_path,
+                interface_name,
+                method_name)
+            ) ) {
+            std::cerr << "ERROR: dbus_message_new_method_call - Unable to allocate memory for the message!" << std::endl;
+            shared->promise.set_value(false);
+            return;
+        }
+        if (appendArgs && false == appendArgs(method_call)) {
+            dbus_message_unref(method_call);
+            shared->promise.set_value(false);
+            return;
+        }
+
+        ++(this->pending_calls);
+        const bool sent = this->dispatcher->send(method_call, DBUS_TIMEOUT_USE_DEFAULT, [shared] (DBusMessage* reply) {
+            DBusClient::completeCall(shared.get(), reply);
+        });
+        dbus_message_unref(method_call);
+        if (false == sent) {
+            std::cerr << "ERROR: DBusDispatcher - Unable to send the message!" << std::endl;
+            this->DBusClient::finishCall();
+            shared->promise.set_value(false);
+        }
+    }
+
+    static void onPendingCallNotify(DBusPendingCall* pending, void* user_data) {
+        DBusMessage* reply = dbus_pending_call_steal_reply(pending);
+        DBusClient::completeCall(static_cast<PendingContext*>(user_data), reply);
+        if (reply) {
+            dbus_message_unref(reply);
+        }
+    }
+
+    // Parse the reply and fulfil the promise (reply is borrowed)
+    static void completeCall(PendingContext* context, DBusMessage* reply) {
+        bool parsed = false;
+
+        // Error reply (also covers timeout, which turns into NoReply)
+        DBusError error;
+        dbus_error_init(&error);
+        if ( reply && true == dbus_set_error_from_message(&error, reply) ) {
+            std::cerr << error.name << std::endl << error.message << std::endl;
+            dbus_error_free(&error);
+        }
+        else if (reply) {
+            // Parse response and Store
+            if (context->parseFunc) {
+                context->parseFunc(reply);
+            }
+            parsed = true;
+        }
+
+        // Only after parsing: waitPending() callers read what the parser stored
+        context->client->DBusClient::finishCall();
+        context->promise.set_value(parsed);
+    }
+
+    // One call less in flight; wakes waitPending() on the last one
+    // (counted under the lock, so a waiter cannot miss the wakeup)
+    void finishCall() {
+        std::lock_guard<std::mutex> lock(this->pending_mutex);
+        if (0 == --(this->pending_calls)) {
+            this->pending_done.notify_all();
+        }
+    }
+
+    static void freePendingContext(void* user_data) {
+        delete static_cast<PendingContext*>(user_data);
+    }
 };
@@ -12,18 +12,38 @@ private:
     DBusError error;
 private:
     DBusConnection* conn;
+    // Peer-to-peer connection (not shared, must be closed by us)
+    bool is_private;
 
 public:
     // Constructor
-    DBusConn(DBusBusType type)
+    DBusConn(DBusBusType type) : is_private(false)
     {
         dbus_error_init(&error);
 
+        // Make libdbus thread-safe before the connection exists
+        // (needed by services that reply from worker threads)
+        dbus_threads_init_default();
+
         // Connect to D-Bus
         if ( nullptr == (conn = dbus_bus_get(type, &error)) ) {
             std::cerr << error.name << std::endl << error.message << std::endl;
         }
     }
+    // Constructor (direct connection to a peer, no bus daemon in between)
+    // address: e.g. "unix:path=/tmp/calc.sock" as passed to dbus_server_listen()
+    DBusConn(const char* address) : is_private(true)
+    {
+        dbus_error_init(&error);
+
+        // Make libdbus thread-safe before the connection exists
+        dbus_threads_init_default();
+
+        // Connect to peer
+        if ( nullptr == (conn = dbus_connection_open_private(address, &error)) ) {
+            std::cerr << error.name << std::endl << error.message << std::endl;
+        }
+    }
     // delete
     DBusConn(DBusConn&& other) = delete;
     DBusConn& operator=(DBusConn&& other) = delete;
@@ -37,6 +57,11 @@ public:
         // see dbus_connection_close() docs. This is a bug in the application.
         // dbus_connection_close(dbus_conn);
 
+        // Private (peer) connections are ours and have to be closed first
+        if (conn && is_private) {
+            dbus_connection_close(conn);
+        }
+
         // When using the System Bus, unreference the connection instead of closing it
         if (conn) {
             dbus_connection_unref(conn);
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <unordered_map>
+#include <dbus/dbus.h>
+
+#include "dbus_event_loop.hpp"
+#include "dbus_mpsc_queue.hpp"
+
+//
+// Dispatcher
+//
+// Makes one connection usable from any number of threads. A dedicated I/O
+// thread owns the DBusConnection: it is the only thread that sends, reads
+// or dispatches on it, so callers never meet on the libdbus connection lock.
+// Callers hand method calls over through a lock-free MPSC queue and an
+// eventfd wakeup; the I/O thread sends them, keeps them by serial number,
+// and a filter routes each method return / error back to its caller by
+// reply serial. Calls without an answer in time get a NoReply error.
+//
+//   DBusDispatcher dispatcher(conn);
+//   DBusMessage* reply = dispatcher.call(method_call, DBUS_TIMEOUT_USE_DEFAULT);
+//
+// Completions run on the I/O thread: they must not block on another call.
+// While the dispatcher exists nobody else may use the connection. A send()
+// racing the destructor is failed, never lost, but callers must still be
+// done calling into the dispatcher before its storage goes away.
+
+class DBusDispatcher {
+public:
+    // reply: method return or error (borrowed; ref it to keep it), nullptr if out of memory
+    using Completion = std::function<void(DBusMessage* reply)>;
+    // Same as libdbus for DBUS_TIMEOUT_USE_DEFAULT
+    static constexpr int kDefaultTimeoutMs = 25000;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        DBusMessage* message;
+        int timeout_ms;
+        Completion done;
+    };
+
+    struct InFlight {
+        DBusMessage* message;
+        std::multimap<Clock::time_point, dbus_uint32_t>::iterator deadline;
+        Completion done;
+    };
+
+private:
+    DBusConnection* conn;
+    DBusEventLoop loop;
+    MpscQueue<Request> submitted;
+    std::atomic<bool> stopping;
+    // send() calls between their stopping check and their push
+    std::atomic<size_t> senders;
+    std::thread io_thread;
+private:
+    // I/O thread only
+    std::unordered_map<dbus_uint32_t, InFlight> in_flight;
+    std::multimap<Clock::time_point, dbus_uint32_t> deadlines;
+    int timer_id;
+    Clock::time_point armed;
+
+public:
+    // Constructor
+    explicit DBusDispatcher(DBusConnection* dc) :
+        conn(dc),
+        stopping(false),
+        senders(0),
+        timer_id(-1)
+    {
+        // Replies are routed between threads from now on
+        dbus_threads_init_default();
+
+        if (nullptr == this->conn) {
+            return;
+        }
+        dbus_connection_ref(this->conn);
+        if ( false == dbus_connection_add_filter(this->conn, DBusDispatcher::onMessage, this, nullptr) ) {
+            std::cerr << "ERROR: dbus_connection_add_filter - Unable to allocate memory!" << std::endl;
+        }
+        if ( false == this->loop.addConnection(this->conn) ) {
+            std::cerr << "ERROR: Unable to attach the connection to the dispatcher loop!" << std::endl;
+        }
+        this->loop.setWakeHandler( [this] () { this->DBusDispatcher::onWake(); } );
+
+        io_thread = std::thread( [this] () { this->loop.run(); } );
+    }
+    // delete
+    DBusDispatcher() = delete;
+    DBusDispatcher(DBusDispatcher&& other) = delete;
+    DBusDispatcher& operator=(DBusDispatcher&& other) = delete;
+    DBusDispatcher(const DBusDispatcher&) = delete;
+    DBusDispatcher& operator=(const DBusDispatcher&) = delete;
+    // De-Constructor (calls still waiting complete with an error)
+    ~DBusDispatcher() {
+        if (nullptr == this->conn) {
+            return;
+        }
+
+        // The I/O thread fails what it holds and leaves its loop
+        this->stopping.store(true);
+        this->loop.wakeup();
+        io_thread.join();
+
+        // A send() that saw stopping == false may still be pushing: let it
+        // finish, then fail what was submitted after the last drain
+        while (0 != this->senders.load()) {
+            std::this_thread::yield();
+        }
+        this->submitted.drain( [] (Request& request) {
+            DBusDispatcher::fail(request.message, request.done, DBUS_ERROR_DISCONNECTED, "Dispatcher stopped");
+        } );
+
+        // Hand the connection back in its original state
+        this->loop.removeConnection(this->conn);
+        dbus_connection_remove_filter(this->conn, DBusDispatcher::onMessage, this);
+        dbus_connection_unref(this->conn);
+    }
+
+public:
+    // Queue a method call (thread-safe, never blocks); done runs once on the
+    // I/O thread with the reply. false (done not called) once stopping.
+    bool send(DBusMessage* method_call, int timeout_ms, Completion done) {
+        if (nullptr == this->conn) {
+            return false;
+        }
+        // Registered before the check (both seq_cst): either the destructor
+        // sees this sender and waits for the push, or this sees stopping
+        this->senders.fetch_add(1);
+        if (this->stopping.load()) {
+            this->senders.fetch_sub(1);
+            return false;
+        }
+        if (timeout_ms < 0) {
+            timeout_ms = kDefaultTimeoutMs;
+        }
+
+        dbus_message_ref(method_call);
+        if (this->submitted.push(Request{ method_call, timeout_ms, std::move(done) })) {
+            this->loop.wakeup();
+        }
+        this->senders.fetch_sub(1);
+        return true;
+    }
+
+    // Send and wait for the reply (caller unrefs it); nullptr if it could not be sent.
+    // Not from a completion: the I/O thread would wait for itself.
+    DBusMessage* call(DBusMessage* method_call, int timeout_ms) {
+        std::promise<DBusMessage*> promise;
+        std::future<DBusMessage*> result = promise.get_future();
+        const bool sent = this->DBusDispatcher::send(method_call, timeout_ms, [&promise] (DBusMessage* reply) {
+            promise.set_value(reply ? dbus_message_ref(reply) : nullptr);
+        });
+        if (false == sent) {
+            return nullptr;
+        }
+        return result.get();
+    }
+
+private:
+    //
+    // I/O thread
+    //
+
+    void onWake() {
+        this->submitted.drain( [this] (Request& request) {
+            this->DBusDispatcher::start(request);
+        } );
+        this->DBusDispatcher::armTimer();
+
+        if (this->stopping.load()) {
+            this->DBusDispatcher::failAll(DBUS_ERROR_DISCONNECTED, "Dispatcher stopped");
+            this->loop.stop();
+        }
+    }
+
+    void start(Request& request) {
+        dbus_uint32_t serial = 0;
+        if ( false == dbus_connection_send(this->conn, request.message, &serial) ) {
+            DBusDispatcher::fail(request.message, request.done, DBUS_ERROR_NO_MEMORY, "Unable to send the message");
+            return;
+        }
+
+        // A message sent before keeps its serial: its reply could not be told apart
+        if (this->in_flight.find(serial) != this->in_flight.end()) {
+            DBusDispatcher::fail(request.message, request.done, DBUS_ERROR_INVALID_ARGS, "Message is already waiting for a reply");
+            return;
+        }
+
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(request.timeout_ms);
+        this->in_flight.emplace(serial, InFlight{
+            request.message,
+            this->deadlines.emplace(deadline, serial),
+            std::move(request.done) });
+    }
+
+    static DBusHandlerResult onMessage(DBusConnection* /*conn*/, DBusMessage* message, void* data) {
+        DBusDispatcher* dispatcher = static_cast<DBusDispatcher*>(data);
+
+        const int type = dbus_message_get_type(message);
+        if (DBUS_MESSAGE_TYPE_METHOD_RETURN != type && DBUS_MESSAGE_TYPE_ERROR != type) {
+            if (dbus_message_is_signal(message, DBUS_INTERFACE_LOCAL, "Disconnected")) {
+                dispatcher->DBusDispatcher::failAll(DBUS_ERROR_DISCONNECTED, "Connection closed");
+            }
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+
+        auto it = dispatcher->in_flight.find(dbus_message_get_reply_serial(message));
+        if (it == dispatcher->in_flight.end()) {
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+        InFlight call = std::move(it->second);
+        dispatcher->deadlines.erase(call.deadline);
+        dispatcher->in_flight.erase(it);
+
+        if (call.done) {
+            call.done(message);
+        }
+        dbus_message_unref(call.message);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
+    // One one-shot timer for the earliest deadline
+    void armTimer() {
+        if (this->deadlines.empty()) {
+            return;
+        }
+        const Clock::time_point earliest = this->deadlines.begin()->first;
+        if (this->timer_id >= 0 && this->armed <= earliest) {
+            return;
+        }
+        if (this->timer_id >= 0) {
+            this->loop.removeTimer(this->timer_id);
+        }
+
+        // A zero interval would disarm the timer
+        const auto wait = std::chrono::duration_cast<std::chrono::microseconds>(earliest - Clock::now());
+        this->timer_id = this->loop.addTimer(
+            std::max(wait, std::chrono::microseconds(1)),
+            [this] () { this->DBusDispatcher::expire(); },
+            false);
+        this->armed = earliest;
+    }
+
+    void expire() {
+        this->loop.removeTimer(this->timer_id);
+        this->timer_id = -1;
+
+        const Clock::time_point now = Clock::now();
+        while (false == this->deadlines.empty() && this->deadlines.begin()->first <= now) {
+            auto it = this->in_flight.find(this->deadlines.begin()->second);
+            this->deadlines.erase(this->deadlines.begin());
+            if (it == this->in_flight.end()) {
+                continue;
+            }
+            InFlight call = std::move(it->second);
+            this->in_flight.erase(it);
+            DBusDispatcher::fail(call.message, call.done, DBUS_ERROR_NO_REPLY, "Did not receive a reply in time");
+        }
+        this->DBusDispatcher::armTimer();
+    }
+
+    void failAll(const char* name, const char* text) {
+        std::unordered_map<dbus_uint32_t, InFlight> calls;
+        calls.swap(this->in_flight);
+        this->deadlines.clear();
+        for (auto& entry : calls) {
+            DBusDispatcher::fail(entry.second.message, entry.second.done, name, text);
+        }
+    }
+
+    // Complete a call with a locally made error (the caller sees it like one from the bus)
+    static void fail(DBusMessage* message, Completion& done, const char* name, const char* text) {
+        DBusMessage* error = dbus_message_new(DBUS_MESSAGE_TYPE_ERROR);
+        if ( error
+            && ( false == dbus_message_set_error_name(error, name)
+                || false == dbus_message_append_args(error, DBUS_TYPE_STRING, &text, DBUS_TYPE_INVALID) ) ) {
+            dbus_message_unref(error);
+            error = nullptr;
+        }
+
+        if (done) {
+            done(error);
+        }
+        if (error) {
+            dbus_message_unref(error);
+        }
+        dbus_message_unref(message);
+    }
+};
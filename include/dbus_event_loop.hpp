@@ -0,0 +1,473 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <dbus/dbus.h>
+
+//
+// Event Loop
+//
+// Drives any number of DBusConnections (plus plain timers) from one thread.
+// libdbus tells us which fds and timeouts it needs through the watch and
+// timeout callbacks; they are mapped onto one epoll set and one timerfd per
+// timeout. After each wakeup every connection is dispatched, so messages are
+// delivered to the filters / object handlers registered on it.
+
+class DBusEventLoop {
+private:
+    enum class SourceType { WAKE, WATCH, TIMER };
+
+    // Every epoll registration points at one of these
+    struct Source {
+        SourceType type;
+        int fd;
+        // TIMER: handed out by addTimer; unlike the fd it is never reused
+        int id;
+        bool dead;
+        // WATCH: all libdbus watches sharing the fd (read + write watch)
+        std::vector<DBusWatch*> watches;
+        // TIMER: libdbus timeout or user callback
+        DBusTimeout* timeout;
+        std::function<void()> callback;
+    };
+
+private:
+    int epoll_fd;
+    Source wake;
+    std::atomic<bool> running;
+    std::thread::id loop_thread;
+private:
+    std::unordered_map<int, Source*> watch_sources;
+    // Keyed by Source::id
+    std::unordered_map<int, Source*> timer_sources;
+    int next_timer_id;
+    std::vector<Source*> graveyard;
+    std::vector<DBusConnection*> connections;
+    // Run on the loop thread after each wakeup()
+    std::function<void()> on_wake;
+
+public:
+    // Constructor
+    DBusEventLoop() :
+        epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+        wake{ SourceType::WAKE, eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), -1, false, {}, nullptr, nullptr },
+        running(false),
+        next_timer_id(0)
+    {
+        if (this->epoll_fd < 0 || this->wake.fd < 0) {
+            std::cerr << "Event loop: epoll/eventfd creation failed" << std::endl;
+            return;
+        }
+        this->DBusEventLoop::control(EPOLL_CTL_ADD, &(this->wake), EPOLLIN);
+    }
+    // delete
+    DBusEventLoop(DBusEventLoop&& other) = delete;
+    DBusEventLoop& operator=(DBusEventLoop&& other) = delete;
+    DBusEventLoop(const DBusEventLoop&) = delete;
+    DBusEventLoop& operator=(const DBusEventLoop&) = delete;
+    // De-Constructor
+    ~DBusEventLoop() {
+        // Detach from libdbus first (this removes its watches and timeouts)
+        while (false == this->connections.empty()) {
+            this->DBusEventLoop::removeConnection(this->connections.back());
+        }
+        for (auto& entry : this->timer_sources) {
+            close(entry.second->fd);
+            delete entry.second;
+        }
+        for (auto& entry : this->watch_sources) {
+            delete entry.second;
+        }
+        this->DBusEventLoop::reap();
+        if (this->wake.fd >= 0) {
+            close(this->wake.fd);
+        }
+        if (this->epoll_fd >= 0) {
+            close(this->epoll_fd);
+        }
+    }
+
+public:
+    // Let this loop drive the connection (watches, timeouts, dispatch)
+    bool addConnection(DBusConnection* conn) {
+        if ( false == dbus_connection_set_watch_functions(conn,
+                DBusEventLoop::onAddWatch, DBusEventLoop::onRemoveWatch, DBusEventLoop::onToggleWatch,
+                this, nullptr) ) {
+            return false;
+        }
+        if ( false == dbus_connection_set_timeout_functions(conn,
+                DBusEventLoop::onAddTimeout, DBusEventLoop::onRemoveTimeout, DBusEventLoop::onToggleTimeout,
+                this, nullptr) ) {
+            dbus_connection_set_watch_functions(conn, nullptr, nullptr, nullptr, nullptr, nullptr);
+            return false;
+        }
+        // Another thread queued a message: wake up so it gets written
+        dbus_connection_set_wakeup_main_function(conn, DBusEventLoop::onWakeup, this, nullptr);
+        dbus_connection_set_dispatch_status_function(conn, DBusEventLoop::onDispatchStatus, this, nullptr);
+
+        dbus_connection_ref(conn);
+        this->connections.push_back(conn);
+        return true;
+    }
+
+    void removeConnection(DBusConnection* conn) {
+        auto it = std::find(this->connections.begin(), this->connections.end(), conn);
+        if (it == this->connections.end()) {
+            return;
+        }
+        this->connections.erase(it);
+
+        dbus_connection_set_dispatch_status_function(conn, nullptr, nullptr, nullptr);
+        dbus_connection_set_wakeup_main_function(conn, nullptr, nullptr, nullptr);
+        dbus_connection_set_timeout_functions(conn, nullptr, nullptr, nullptr, nullptr, nullptr);
+        dbus_connection_set_watch_functions(conn, nullptr, nullptr, nullptr, nullptr, nullptr);
+        dbus_connection_unref(conn);
+    }
+
+    // Drive a libdbus listening socket (see dbus_server_listen);
+    // ::DBusServer is the libdbus C struct that shares its name with our class
+    bool addListener(::DBusServer* listener) {
+        if ( false == dbus_server_set_watch_functions(listener,
+                DBusEventLoop::onAddWatch, DBusEventLoop::onRemoveWatch, DBusEventLoop::onToggleWatch,
+                this, nullptr) ) {
+            return false;
+        }
+        if ( false == dbus_server_set_timeout_functions(listener,
+                DBusEventLoop::onAddTimeout, DBusEventLoop::onRemoveTimeout, DBusEventLoop::onToggleTimeout,
+                this, nullptr) ) {
+            dbus_server_set_watch_functions(listener, nullptr, nullptr, nullptr, nullptr, nullptr);
+            return false;
+        }
+        return true;
+    }
+
+    void removeListener(::DBusServer* listener) {
+        dbus_server_set_timeout_functions(listener, nullptr, nullptr, nullptr, nullptr, nullptr);
+        dbus_server_set_watch_functions(listener, nullptr, nullptr, nullptr, nullptr, nullptr);
+    }
+
+    // Periodic (or one-shot) timer run on the loop thread; returns id or -1
+    int addTimer(std::chrono::microseconds interval, std::function<void()> callback, bool repeat = true) {
+        Source* source = this->DBusEventLoop::newTimer(nullptr, std::move(callback));
+        if (nullptr == source) {
+            return -1;
+        }
+        DBusEventLoop::arm(source->fd, interval, repeat);
+        return source->id;
+    }
+
+    void removeTimer(int id) {
+        auto it = this->timer_sources.find(id);
+        if (it != this->timer_sources.end()) {
+            this->DBusEventLoop::dropTimer(it->second);
+        }
+    }
+
+    // Called on the loop thread whenever wakeup() interrupted it
+    // (e.g. to pick up work queued by other threads)
+    void setWakeHandler(std::function<void()> handler) {
+        this->on_wake = std::move(handler);
+    }
+
+    // Serve until stop()
+    void run() {
+        if (this->epoll_fd < 0) {
+            return;
+        }
+
+        this->running.store(true);
+        this->loop_thread = std::this_thread::get_id();
+        const int max_events = 32;
+        struct epoll_event events[max_events];
+
+        // Messages may already be queued before the first wakeup
+        this->DBusEventLoop::dispatchAll();
+
+        while (this->running.load()) {
+            int n = epoll_wait(this->epoll_fd, events, max_events, -1);
+            if (n < 0) {
+                continue;
+            }
+
+            for (int i = 0; i < n; ++i) {
+                Source* source = static_cast<Source*>(events[i].data.ptr);
+                if (source->dead) {
+                    continue;
+                }
+                switch (source->type) {
+                case SourceType::WAKE: {
+                    eventfd_t value;
+                    eventfd_read(source->fd, &value);
+                    if (this->on_wake) {
+                        this->on_wake();
+                    }
+                    break;
+                }
+                case SourceType::WATCH:
+                    DBusEventLoop::handleWatches(source, events[i].events);
+                    break;
+                case SourceType::TIMER:
+                    this->DBusEventLoop::handleTimer(source);
+                    break;
+                }
+            }
+
+            this->DBusEventLoop::dispatchAll();
+            this->DBusEventLoop::reap();
+        }
+    }
+
+    // Thread-safe and async-signal-safe
+    void stop() {
+        this->running.store(false);
+        this->DBusEventLoop::wakeup();
+    }
+
+    void wakeup() {
+        eventfd_write(this->wake.fd, 1);
+    }
+
+private:
+    void dispatchAll() {
+        // Handlers may remove (and drop the last reference to) a connection
+        const std::vector<DBusConnection*> snapshot = this->connections;
+        for (DBusConnection* conn : snapshot) {
+            dbus_connection_ref(conn);
+            while (DBUS_DISPATCH_DATA_REMAINS == dbus_connection_get_dispatch_status(conn)) {
+                dbus_connection_dispatch(conn);
+            }
+            dbus_connection_unref(conn);
+        }
+    }
+
+    static void handleWatches(Source* source, uint32_t events) {
+        unsigned int flags = 0;
+        if (events & EPOLLIN)  { flags |= DBUS_WATCH_READABLE; }
+        if (events & EPOLLOUT) { flags |= DBUS_WATCH_WRITABLE; }
+        if (events & EPOLLERR) { flags |= DBUS_WATCH_ERROR; }
+        if (events & EPOLLHUP) { flags |= DBUS_WATCH_HANGUP; }
+
+        // Handling may add/remove watches, so work on a copy
+        const std::vector<DBusWatch*> watches = source->watches;
+        for (DBusWatch* watch : watches) {
+            if (source->dead) {
+                return;
+            }
+            if (false == dbus_watch_get_enabled(watch)) {
+                continue;
+            }
+            unsigned int wanted = dbus_watch_get_flags(watch) | DBUS_WATCH_ERROR | DBUS_WATCH_HANGUP;
+            if (flags & wanted) {
+                dbus_watch_handle(watch, flags & wanted);
+            }
+        }
+    }
+
+    void handleTimer(Source* source) {
+        uint64_t expirations = 0;
+        if (read(source->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            return;
+        }
+        if (source->timeout) {
+            dbus_timeout_handle(source->timeout);
+        }
+        else if (source->callback) {
+            source->callback();
+        }
+    }
+
+    //
+    // epoll bookkeeping
+    //
+
+    bool control(int op, Source* source, uint32_t events) {
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.ptr = source;
+        return 0 == epoll_ctl(this->epoll_fd, op, source->fd, &ev);
+    }
+
+    // Interest = union of the enabled watches on the fd
+    void updateWatchSource(Source* source) {
+        uint32_t events = 0;
+        for (DBusWatch* watch : source->watches) {
+            if (false == dbus_watch_get_enabled(watch)) {
+                continue;
+            }
+            unsigned int flags = dbus_watch_get_flags(watch);
+            if (flags & DBUS_WATCH_READABLE) { events |= EPOLLIN; }
+            if (flags & DBUS_WATCH_WRITABLE) { events |= EPOLLOUT; }
+        }
+        this->DBusEventLoop::control(EPOLL_CTL_MOD, source, events);
+    }
+
+    Source* newTimer(DBusTimeout* timeout, std::function<void()> callback) {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        Source* source = new Source{ SourceType::TIMER, fd, this->DBusEventLoop::nextTimerId(), false, {}, timeout, std::move(callback) };
+        if ( false == this->DBusEventLoop::control(EPOLL_CTL_ADD, source, EPOLLIN) ) {
+            close(fd);
+            delete source;
+            return nullptr;
+        }
+        this->timer_sources[source->id] = source;
+        return source;
+    }
+
+    // The timerfd number is recycled as soon as it is closed, so a stale id
+    // would cancel whichever timer got it next; ids only wrap after INT_MAX
+    int nextTimerId() {
+        do {
+            this->next_timer_id = (INT_MAX == this->next_timer_id) ? 0 : this->next_timer_id + 1;
+        } while (this->timer_sources.end() != this->timer_sources.find(this->next_timer_id));
+        return this->next_timer_id;
+    }
+
+    void dropTimer(Source* source) {
+        epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, source->fd, nullptr);
+        this->timer_sources.erase(source->id);
+        close(source->fd);
+        source->fd = -1;
+        source->dead = true;
+        this->graveyard.push_back(source);
+    }
+
+    static void arm(int fd, std::chrono::microseconds interval, bool repeat) {
+        struct itimerspec spec = {};
+        if (interval.count() > 0) {
+            spec.it_value.tv_sec = interval.count() / 1000000;
+            spec.it_value.tv_nsec = (interval.count() % 1000000) * 1000;
+            if (repeat) {
+                spec.it_interval = spec.it_value;
+            }
+        }
+        timerfd_settime(fd, 0, &spec, nullptr);
+    }
+
+    // Sources can be removed while their events are still in the batch
+    void reap() {
+        for (Source* source : this->graveyard) {
+            delete source;
+        }
+        this->graveyard.clear();
+    }
+
+    //
+    // libdbus callbacks
+    //
+
+    static dbus_bool_t onAddWatch(DBusWatch* watch, void* data) {
+        DBusEventLoop* loop = static_cast<DBusEventLoop*>(data);
+        int fd = dbus_watch_get_unix_fd(watch);
+
+        Source* source = nullptr;
+        auto it = loop->watch_sources.find(fd);
+        if (it == loop->watch_sources.end()) {
+            source = new Source{ SourceType::WATCH, fd, -1, false, {}, nullptr, nullptr };
+            if ( false == loop->DBusEventLoop::control(EPOLL_CTL_ADD, source, 0) ) {
+                delete source;
+                return FALSE;
+            }
+            loop->watch_sources[fd] = source;
+        }
+        else {
+            source = it->second;
+        }
+
+        source->watches.push_back(watch);
+        loop->DBusEventLoop::updateWatchSource(source);
+        return TRUE;
+    }
+
+    static void onRemoveWatch(DBusWatch* watch, void* data) {
+        DBusEventLoop* loop = static_cast<DBusEventLoop*>(data);
+        auto it = loop->watch_sources.find(dbus_watch_get_unix_fd(watch));
+        if (it == loop->watch_sources.end()) {
+            return;
+        }
+
+        Source* source = it->second;
+        source->watches.erase(std::remove(source->watches.begin(), source->watches.end(), watch), source->watches.end());
+        if (false == source->watches.empty()) {
+            loop->DBusEventLoop::updateWatchSource(source);
+            return;
+        }
+
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, source->fd, nullptr);
+        loop->watch_sources.erase(it);
+        source->dead = true;
+        loop->graveyard.push_back(source);
+    }
+
+    static void onToggleWatch(DBusWatch* watch, void* data) {
+        DBusEventLoop* loop = static_cast<DBusEventLoop*>(data);
+        auto it = loop->watch_sources.find(dbus_watch_get_unix_fd(watch));
+        if (it != loop->watch_sources.end()) {
+            loop->DBusEventLoop::updateWatchSource(it->second);
+        }
+    }
+
+    static dbus_bool_t onAddTimeout(DBusTimeout* timeout, void* data) {
+        DBusEventLoop* loop = static_cast<DBusEventLoop*>(data);
+        Source* source = loop->DBusEventLoop::newTimer(timeout, nullptr);
+        if (nullptr == source) {
+            return FALSE;
+        }
+        dbus_timeout_set_data(timeout, source, nullptr);
+        onToggleTimeout(timeout, data);
+        return TRUE;
+    }
+
+    static void onRemoveTimeout(DBusTimeout* timeout, void* data) {
+        DBusEventLoop* loop = static_cast<DBusEventLoop*>(data);
+        Source* source = static_cast<Source*>(dbus_timeout_get_data(timeout));
+        if (source) {
+            dbus_timeout_set_data(timeout, nullptr, nullptr);
+            loop->DBusEventLoop::dropTimer(source);
+        }
+    }
+
+    static void onToggleTimeout(DBusTimeout* timeout, void* /*data*/) {
+        Source* source = static_cast<Source*>(dbus_timeout_get_data(timeout));
+        if (nullptr == source) {
+            return;
+        }
+        std::chrono::microseconds interval(0);
+        if (dbus_timeout_get_enabled(timeout)) {
+            interval = std::chrono::milliseconds(std::max(1, dbus_timeout_get_interval(timeout)));
+        }
+        DBusEventLoop::arm(source->fd, interval, true);
+    }
+
+    // Only other threads need to interrupt epoll_wait
+    void wakeupFromOtherThread() {
+        if (std::this_thread::get_id() != this->loop_thread) {
+            this->DBusEventLoop::wakeup();
+        }
+    }
+
+    static void onWakeup(void* data) {
+        static_cast<DBusEventLoop*>(data)->DBusEventLoop::wakeupFromOtherThread();
+    }
+
+    static void onDispatchStatus(DBusConnection* /*conn*/, DBusDispatchStatus status, void* data) {
+        // Data queued outside the loop thread (e.g. by a blocking call)
+        if (DBUS_DISPATCH_DATA_REMAINS == status) {
+            static_cast<DBusEventLoop*>(data)->DBusEventLoop::wakeupFromOtherThread();
+        }
+    }
+};
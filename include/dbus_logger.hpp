@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+
+#include "dbus_ring_buffer.hpp"
+
+//
+// Logger
+//
+// Asynchronous line logger for hot paths. A call formats its arguments into
+// a fixed-size record (no allocation, no stream, no flush) and pushes it into
+// a lock-free RingBuffer; a background thread batches the records into
+// write() calls. A record below the current level costs one comparison.
+//
+//   Logger::info("Property set: ", name, " = ", value);
+//   if (Logger::enabled(LogLevel::DEBUG)) { ...expensive dump... }
+//
+// The level comes from DBUS_LOG_LEVEL (debug, info, warn, error, off),
+// default info. DEBUG / INFO lines go to stdout, WARN / ERROR to stderr.
+// A full queue drops the new line (the hot path never waits) and the writer
+// reports how many were lost. Lines longer than a record are truncated.
+
+enum class LogLevel : int { DEBUG = 0, INFO = 1, WARN = 2, ERROR = 3, OFF = 4 };
+
+class Logger {
+public:
+    static constexpr size_t kLineSize = 240;
+    static constexpr size_t kQueueSize = 4096;
+
+private:
+    struct Record {
+        LogLevel level;
+        uint32_t length;
+        char text[kLineSize];
+    };
+
+private:
+    std::atomic<int> threshold;
+    RingBuffer<Record> queue;
+    std::atomic<uint64_t> queued;
+    std::atomic<uint64_t> written;
+    std::thread writer;
+
+public:
+    // Constructor
+    Logger() :
+        threshold(static_cast<int>(Logger::levelFromEnv())),
+        queue(kQueueSize, RingOverflow::DROP_NEWEST),
+        queued(0),
+        written(0)
+    {
+        writer = std::thread( [this] () { this->Logger::work(); } );
+    }
+    // delete
+    Logger(Logger&& other) = delete;
+    Logger& operator=(Logger&& other) = delete;
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    // De-Constructor (writes what is still queued)
+    ~Logger() {
+        queue.close();
+        writer.join();
+    }
+
+public:
+    // Process-wide instance (writer thread starts on first use)
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= Logger::instance().threshold.load(std::memory_order_relaxed);
+    }
+
+    static void setLevel(LogLevel level) {
+        Logger::instance().threshold.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    template<typename... Args>
+    static void debug(const Args&... args) { Logger::log(LogLevel::DEBUG, args...); }
+    template<typename... Args>
+    static void info(const Args&... args) { Logger::log(LogLevel::INFO, args...); }
+    template<typename... Args>
+    static void warn(const Args&... args) { Logger::log(LogLevel::WARN, args...); }
+    template<typename... Args>
+    static void error(const Args&... args) { Logger::log(LogLevel::ERROR, args...); }
+
+    template<typename... Args>
+    static void log(LogLevel level, const Args&... args) {
+        if (false == Logger::enabled(level)) {
+            return;
+        }
+
+        Record record;
+        record.level = level;
+        record.length = 0;
+        (Logger::append(record, args), ...);
+
+        Logger& logger = Logger::instance();
+        logger.queued.fetch_add(1, std::memory_order_relaxed);
+        logger.queue.push(record);
+    }
+
+    // Wait until every line logged so far is written (e.g. before printing
+    // a summary with std::cout, so the output stays in order)
+    static void flush() {
+        Logger& logger = Logger::instance();
+        const uint64_t target = logger.queued.load();
+        while (logger.written.load() + logger.queue.dropped() < target) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+private:
+    static void append(Record& record, std::string_view value) {
+        const size_t n = std::min(value.size(), kLineSize - record.length);
+        std::memcpy(record.text + record.length, value.data(), n);
+        record.length += n;
+    }
+    static void append(Record& record, const char* value) {
+        Logger::append(record, std::string_view(value != nullptr ? value : "(null)"));
+    }
+    static void append(Record& record, const std::string& value) {
+        Logger::append(record, std::string_view(value));
+    }
+    static void append(Record& record, char value) {
+        Logger::append(record, std::string_view(&value, 1));
+    }
+    static void append(Record& record, bool value) {
+        Logger::append(record, std::string_view(value ? "true" : "false"));
+    }
+    // Integers and floating point (shortest round-trip form)
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    static void append(Record& record, T value) {
+        char digits[32];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        Logger::append(record, std::string_view(digits, result.ptr - digits));
+    }
+
+    void work() {
+        // One write() per stream per batch of records
+        std::string out;
+        std::string err;
+        uint64_t reported_drops = 0;
+        Record record;
+
+        while (queue.pop(record)) {
+            uint64_t batch = 0;
+            do {
+                std::string& target = (record.level >= LogLevel::WARN) ? err : out;
+                target.append(record.text, record.length);
+                target.push_back('\n');
+                ++batch;
+            } while (out.size() + err.size() < 64 * 1024 && queue.tryPop(record));
+
+            const uint64_t drops = queue.dropped();
+            if (drops != reported_drops) {
+                err += "[LOG] " + std::to_string(drops - reported_drops) + " line(s) dropped\n";
+                reported_drops = drops;
+            }
+
+            Logger::writeAll(STDOUT_FILENO, out);
+            Logger::writeAll(STDERR_FILENO, err);
+            written.fetch_add(batch);
+        }
+    }
+
+    static void writeAll(int fd, std::string& buffer) {
+        size_t offset = 0;
+        while (offset < buffer.size()) {
+            const ssize_t n = ::write(fd, buffer.data() + offset, buffer.size() - offset);
+            if (n < 0 && EINTR == errno) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            offset += static_cast<size_t>(n);
+        }
+        buffer.clear();
+    }
+
+    static LogLevel levelFromEnv() {
+        const char* value = std::getenv("DBUS_LOG_LEVEL");
+        if (nullptr == value) {
+            return LogLevel::INFO;
+        }
+        const std::string_view name(value);
+        if (name == "debug") { return LogLevel::DEBUG; }
+        if (name == "warn")  { return LogLevel::WARN; }
+        if (name == "error") { return LogLevel::ERROR; }
+        if (name == "off")   { return LogLevel::OFF; }
+        return LogLevel::INFO;
+    }
+};
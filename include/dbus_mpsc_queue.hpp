@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+//
+// MPSC Queue
+//
+// Unbounded lock-free queue for many producers and one consumer. A push is
+// one CAS on the head of a linked list; the consumer takes the whole list
+// with one exchange and walks it oldest first, so producers never wait for
+// each other or for the consumer. push() reports whether the queue was
+// empty: only that push has to wake the consumer, the others are picked up
+// by the drain already due.
+
+template<typename T>
+class MpscQueue {
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+private:
+    std::atomic<Node*> head;
+
+public:
+    // Constructor
+    MpscQueue() : head(nullptr) {}
+    // delete
+    MpscQueue(MpscQueue&& other) = delete;
+    MpscQueue& operator=(MpscQueue&& other) = delete;
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    // De-Constructor (items still queued are discarded; drain first if they own something)
+    ~MpscQueue() {
+        this->MpscQueue::drain([] (T&) {});
+    }
+
+public:
+    // true if the queue was empty before this push (consumer needs a wakeup)
+    bool push(T value) {
+        Node* node = new Node{ std::move(value), nullptr };
+        // Once published the node belongs to the consumer: only read the local copy
+        Node* expected = this->head.load(std::memory_order_relaxed);
+        do {
+            node->next = expected;
+        } while ( false == this->head.compare_exchange_weak(
+                expected, node, std::memory_order_release, std::memory_order_relaxed) );
+        return nullptr == expected;
+    }
+
+    // Consumer only: hand every item queued so far to func, oldest first
+    template<typename Func>
+    size_t drain(Func func) {
+        Node* node = this->head.exchange(nullptr, std::memory_order_acquire);
+
+        // The list is newest first
+        Node* oldest = nullptr;
+        while (node) {
+            Node* next = node->next;
+            node->next = oldest;
+            oldest = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        while (oldest) {
+            Node* next = oldest->next;
+            func(oldest->value);
+            delete oldest;
+            oldest = next;
+            ++count;
+        }
+        return count;
+    }
+
+    bool empty() const {
+        return nullptr == this->head.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <dbus/dbus.h>
+
+#include "dbus_server_wrapper.hpp"
+#include "dbus_event_loop.hpp"
+
+//
+// Peer-to-peer server
+//
+// Listens on a private socket (dbus_server_listen) so clients can connect
+// directly with DBusConn(address), skipping the bus daemon hop. Every
+// accepted connection is served by the same IRouter on a DBusEventLoop.
+// No bus name is owned in this mode; the destination of a call is ignored.
+
+class DBusPeerServer {
+private:
+    DBusError error;
+private:
+    // libdbus listener (the C struct shares its name with our DBusServer class)
+    ::DBusServer* listener;
+    IRouter* controller;
+    DBusEventLoop& loop;
+    std::vector<DBusConnection*> peers;
+
+public:
+    // Constructor
+    // address: e.g. "unix:path=/tmp/calc.sock" or "unix:tmpdir=/tmp"
+    DBusPeerServer(const char* address, IRouter* ctl, DBusEventLoop& el) :
+        listener(nullptr),
+        controller(ctl),
+        loop(el)
+    {
+        dbus_error_init(&error);
+
+        if ( nullptr == (this->listener = dbus_server_listen(address, &(this->error))) ) {
+            std::cerr << "Listen Error: " << this->error.name << std::endl << this->error.message << std::endl;
+            return;
+        }
+
+        dbus_server_set_new_connection_function(this->listener, DBusPeerServer::onNewConnection, this, nullptr);
+        if ( false == this->loop.addListener(this->listener) ) {
+            std::cerr << "Unable to attach listener to event loop" << std::endl;
+            dbus_server_disconnect(this->listener);
+            dbus_server_unref(this->listener);
+            this->listener = nullptr;
+        }
+    }
+    // delete
+    DBusPeerServer() = delete;
+    DBusPeerServer(DBusPeerServer&& other) = delete;
+    DBusPeerServer& operator=(DBusPeerServer&& other) = delete;
+    DBusPeerServer(const DBusPeerServer&) = delete;
+    DBusPeerServer& operator=(const DBusPeerServer&) = delete;
+    // De-Constructor
+    ~DBusPeerServer() {
+        while (false == this->peers.empty()) {
+            DBusConnection* peer = this->peers.back();
+            dbus_connection_close(peer);
+            this->DBusPeerServer::dropPeer(peer);
+        }
+        if (this->listener) {
+            this->loop.removeListener(this->listener);
+            dbus_server_disconnect(this->listener);
+            dbus_server_unref(this->listener);
+        }
+        dbus_error_free(&error);
+    }
+
+public:
+    bool isListening() const {
+        return nullptr != this->listener;
+    }
+
+    // Actual address (includes the generated path for unix:tmpdir=...)
+    std::string getAddress() const {
+        std::string address;
+        if (this->listener) {
+            char* raw = dbus_server_get_address(this->listener);
+            if (raw) {
+                address = raw;
+                dbus_free(raw);
+            }
+        }
+        return address;
+    }
+
+private:
+    void dropPeer(DBusConnection* peer) {
+        auto it = std::find(this->peers.begin(), this->peers.end(), peer);
+        if (it == this->peers.end()) {
+            return;
+        }
+        this->peers.erase(it);
+
+        dbus_connection_remove_filter(peer, DBusPeerServer::onMessage, this);
+        this->loop.removeConnection(peer);
+        dbus_connection_unref(peer);
+    }
+
+    static void onNewConnection(::DBusServer* /*listener*/, DBusConnection* peer, void* user_data) {
+        DBusPeerServer* self = static_cast<DBusPeerServer*>(user_data);
+
+        // Keep it (libdbus drops the connection unless we take a reference)
+        dbus_connection_ref(peer);
+        if ( false == dbus_connection_add_filter(peer, DBusPeerServer::onMessage, self, nullptr)
+            || false == self->loop.addConnection(peer) ) {
+            std::cerr << "Unable to serve new peer connection" << std::endl;
+            dbus_connection_close(peer);
+            dbus_connection_unref(peer);
+            return;
+        }
+        self->peers.push_back(peer);
+    }
+
+    static DBusHandlerResult onMessage(DBusConnection* peer, DBusMessage* message, void* user_data) {
+        DBusPeerServer* self = static_cast<DBusPeerServer*>(user_data);
+
+        // Peer went away
+        if (dbus_message_is_signal(message, DBUS_INTERFACE_LOCAL, "Disconnected")) {
+            self->DBusPeerServer::dropPeer(peer);
+            return DBUS_HANDLER_RESULT_HANDLED;
+        }
+        if (DBUS_MESSAGE_TYPE_METHOD_CALL != dbus_message_get_type(message)) {
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+
+        // Generate response
+        DBusMessage* reply = self->controller->handleRequest(message);
+        if (nullptr != reply) {
+            // Send reply
+            dbus_connection_send(peer, reply, nullptr);
+
+            // Release reply
+            dbus_message_unref(reply);
+        }
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+};
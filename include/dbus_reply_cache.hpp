@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <dbus/dbus.h>
+
+//
+// Reply Cache
+//
+// Bounded LRU of method replies for pure handlers (same arguments, same
+// reply). The key is the interface, member and signature of the call plus
+// its arguments serialized in place (type code + raw value, strings with
+// their length), so two calls with equal argument bytes share one entry.
+// A hit copies the cached reply and only rewrites the reply serial and the
+// destination: the handler does not run and no argument is rebuilt.
+
+class DBusReplyCache {
+private:
+    struct Entry {
+        uint64_t hash;
+        std::string key;
+        DBusMessage* reply;
+    };
+
+private:
+    std::mutex mutex;
+    std::list<Entry> lru;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    size_t capacity;
+
+public:
+    // Constructor
+    explicit DBusReplyCache(size_t max_entries) : capacity(max_entries > 0 ? max_entries : 1) {}
+    // delete
+    DBusReplyCache() = delete;
+    DBusReplyCache(DBusReplyCache&& other) = delete;
+    DBusReplyCache& operator=(DBusReplyCache&& other) = delete;
+    DBusReplyCache(const DBusReplyCache&) = delete;
+    DBusReplyCache& operator=(const DBusReplyCache&) = delete;
+    // De-Constructor
+    ~DBusReplyCache() {
+        for (Entry& entry : lru) {
+            dbus_message_unref(entry.reply);
+        }
+    }
+
+public:
+    // false if the call cannot be cached (e.g. it carries a file descriptor)
+    static bool makeKey(DBusMessage* message, std::string& key, uint64_t& hash) {
+        const char* interface_name = dbus_message_get_interface(message);
+        const char* method_name = dbus_message_get_member(message);
+        const char* signature = dbus_message_get_signature(message);
+
+        key.clear();
+        key.append(interface_name ? interface_name : "").push_back('\0');
+        key.append(method_name ? method_name : "").push_back('\0');
+        key.append(signature ? signature : "").push_back('\0');
+
+        DBusMessageIter iter;
+        if (dbus_message_iter_init(message, &iter)
+            && false == DBusReplyCache::appendArgs(&iter, key)) {
+            return false;
+        }
+
+        // FNV-1a
+        hash = 14695981039346656037ULL;
+        for (unsigned char c : key) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        return true;
+    }
+
+    // Reply for this call, or nullptr on a miss
+    DBusMessage* lookup(DBusMessage* message, const std::string& key, uint64_t hash) {
+        DBusMessage* cached = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = index.find(hash);
+            if (it == index.end() || it->second->key != key) {
+                return nullptr;
+            }
+            lru.splice(lru.begin(), lru, it->second);
+            cached = dbus_message_ref(it->second->reply);
+        }
+
+        // Copy outside the lock (the cached message is never modified)
+        DBusMessage* reply = dbus_message_copy(cached);
+        dbus_message_unref(cached);
+        if ( nullptr == reply
+            || false == dbus_message_set_reply_serial(reply, dbus_message_get_serial(message))
+            || false == dbus_message_set_destination(reply, dbus_message_get_sender(message)) ) {
+            if (reply) {
+                dbus_message_unref(reply);
+            }
+            return nullptr;
+        }
+        return reply;
+    }
+
+    // Keep a copy of a successful reply (errors are not cached)
+    void store(const std::string& key, uint64_t hash, DBusMessage* reply) {
+        if (nullptr == reply || DBUS_MESSAGE_TYPE_METHOD_RETURN != dbus_message_get_type(reply)) {
+            return;
+        }
+        DBusMessage* copy = dbus_message_copy(reply);
+        if (nullptr == copy) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(hash);
+        if (it != index.end()) {
+            // Same key stored by a concurrent miss, or a hash collision: newest wins
+            dbus_message_unref(it->second->reply);
+            lru.erase(it->second);
+            index.erase(it);
+        }
+        lru.push_front(Entry{ hash, key, copy });
+        index.emplace(hash, lru.begin());
+
+        if (lru.size() > capacity) {
+            Entry& oldest = lru.back();
+            index.erase(oldest.hash);
+            dbus_message_unref(oldest.reply);
+            lru.pop_back();
+        }
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lru.size();
+    }
+
+private:
+    static bool appendArgs(DBusMessageIter* iter, std::string& key) {
+        do {
+            const int type = dbus_message_iter_get_arg_type(iter);
+            if (DBUS_TYPE_INVALID == type) {
+                break;
+            }
+            key.push_back(static_cast<char>(type));
+
+            switch (type) {
+            case DBUS_TYPE_UNIX_FD:
+                // Same number, different file
+                return false;
+            case DBUS_TYPE_STRING:
+            case DBUS_TYPE_OBJECT_PATH:
+            case DBUS_TYPE_SIGNATURE: {
+                const char* str = nullptr;
+                dbus_message_iter_get_basic(iter, &str);
+                const uint32_t length = static_cast<uint32_t>(std::strlen(str));
+                key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+                key.append(str, length);
+                break;
+            }
+            case DBUS_TYPE_ARRAY:
+            case DBUS_TYPE_STRUCT:
+            case DBUS_TYPE_DICT_ENTRY:
+            case DBUS_TYPE_VARIANT: {
+                DBusMessageIter sub;
+                dbus_message_iter_recurse(iter, &sub);
+                if (DBUS_TYPE_VARIANT == type) {
+                    // The contained type is part of the value
+                    char* signature = dbus_message_iter_get_signature(&sub);
+                    key.append(signature ? signature : "").push_back('\0');
+                    dbus_free(signature);
+                }
+                key.push_back('(');
+                if (false == DBusReplyCache::appendArgs(&sub, key)) {
+                    return false;
+                }
+                key.push_back(')');
+                break;
+            }
+            default: {
+                // Fixed size basic types (at most 8 bytes)
+                DBusBasicValue value;
+                std::memset(&value, 0, sizeof(value));
+                dbus_message_iter_get_basic(iter, &value);
+                key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+                break;
+            }
+            }
+        } while (dbus_message_iter_next(iter));
+        return true;
+    }
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//
+// Ring Buffer
+//
+// Bounded lock-free queue (per-slot sequence numbers, power-of-two capacity)
+// used to hand messages from an I/O thread to handler threads. push / pop
+// are plain CAS on the head / tail indexes; a mutex is only taken to park a
+// thread that has nothing to do (empty ring, or full ring under BLOCK), and
+// only touched by the other side when someone is actually parked.
+//
+// When the ring is full push() follows the overflow policy:
+//   DROP_OLDEST : evict the oldest queued item to make room
+//   DROP_NEWEST : discard the item being pushed
+//   BLOCK       : wait for a consumer (pushes back on the producer)
+// Evicted / discarded items are passed to the drop callback (e.g. to unref).
+
+enum class RingOverflow { DROP_OLDEST, DROP_NEWEST, BLOCK };
+
+template<typename T>
+class RingBuffer {
+public:
+    using DropCallback = std::function<void(T&)>;
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+private:
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    RingOverflow policy;
+    DropCallback on_drop;
+private:
+    // Separate cache lines: producers and consumers do not share them
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) std::atomic<uint64_t> drop_count;
+    std::atomic<bool> closed;
+private:
+    std::mutex park_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::atomic<int> parked_consumers;
+    std::atomic<int> parked_producers;
+
+public:
+    // Constructor (capacity is rounded up to a power of two)
+    RingBuffer(size_t capacity, RingOverflow overflow, DropCallback drop = nullptr) :
+        mask(RingBuffer::roundUp(capacity) - 1),
+        policy(overflow),
+        on_drop(std::move(drop)),
+        head(0),
+        tail(0),
+        drop_count(0),
+        closed(false),
+        parked_consumers(0),
+        parked_producers(0)
+    {
+        slots.reset(new Slot[mask + 1]);
+        for (size_t i = 0; i <= mask; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    // delete
+    RingBuffer() = delete;
+    RingBuffer(RingBuffer&& other) = delete;
+    RingBuffer& operator=(RingBuffer&& other) = delete;
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+    // De-Constructor (items still queued go to the drop callback)
+    ~RingBuffer() {
+        T item;
+        while (this->RingBuffer::tryPop(item)) {
+            this->RingBuffer::drop(item);
+        }
+    }
+
+public:
+    // false if the item was not queued (DROP_NEWEST on a full ring, or closed);
+    // the item has then already been handed to the drop callback
+    bool push(T item) {
+        int spins = 0;
+        while (false == this->closed.load(std::memory_order_acquire)) {
+            if (this->RingBuffer::tryPush(item)) {
+                this->RingBuffer::notify(this->parked_consumers, this->not_empty);
+                return true;
+            }
+
+            switch (this->policy) {
+            case RingOverflow::DROP_NEWEST:
+                this->RingBuffer::drop(item);
+                return false;
+            case RingOverflow::DROP_OLDEST: {
+                // Compete with consumers for the oldest slot; retry either way
+                T oldest;
+                if (this->RingBuffer::tryPop(oldest)) {
+                    this->RingBuffer::drop(oldest);
+                }
+                break;
+            }
+            case RingOverflow::BLOCK:
+                this->RingBuffer::park(spins, this->parked_producers, this->not_full,
+                    [this] () { return this->RingBuffer::hasSpace() || this->closed.load(); });
+                break;
+            }
+        }
+        this->RingBuffer::drop(item);
+        return false;
+    }
+
+    // Blocks until an item is available; false once closed and drained
+    bool pop(T& item) {
+        int spins = 0;
+        while (true) {
+            if (this->RingBuffer::tryPop(item)) {
+                this->RingBuffer::notify(this->parked_producers, this->not_full);
+                return true;
+            }
+            if (this->closed.load(std::memory_order_acquire)) {
+                // A push may have landed right before close()
+                return this->RingBuffer::tryPop(item);
+            }
+            this->RingBuffer::park(spins, this->parked_consumers, this->not_empty,
+                [this] () { return this->RingBuffer::hasItem() || this->closed.load(); });
+        }
+    }
+
+    bool tryPop(T& item) {
+        size_t pos = this->tail.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = this->slots[pos & this->mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (0 == diff) {
+                if (this->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = std::move(slot.value);
+                    slot.sequence.store(pos + this->mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = this->tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Wake every parked thread; later pushes fail, pops drain what is left
+    void close() {
+        this->closed.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(this->park_mutex);
+        }
+        this->not_empty.notify_all();
+        this->not_full.notify_all();
+    }
+
+    size_t capacity() const {
+        return this->mask + 1;
+    }
+
+    // Items evicted or discarded by the overflow policy
+    uint64_t dropped() const {
+        return this->drop_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    bool tryPush(T& item) {
+        size_t pos = this->head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = this->slots[pos & this->mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (0 == diff) {
+                if (this->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(item);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = this->head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool hasItem() const {
+        const size_t pos = this->tail.load(std::memory_order_acquire);
+        return this->slots[pos & this->mask].sequence.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    bool hasSpace() const {
+        const size_t pos = this->head.load(std::memory_order_acquire);
+        return this->slots[pos & this->mask].sequence.load(std::memory_order_acquire) == pos;
+    }
+
+    void drop(T& item) {
+        this->drop_count.fetch_add(1, std::memory_order_relaxed);
+        if (this->on_drop) {
+            this->on_drop(item);
+        }
+    }
+
+    // Spin / yield a little before sleeping: hand-offs are usually short
+    template<typename Ready>
+    void park(int& spins, std::atomic<int>& parked, std::condition_variable& cv, Ready ready) {
+        if (spins < 64) {
+            ++spins;
+            std::this_thread::yield();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(this->park_mutex);
+        parked.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the fence in notify(): either we see the new state here,
+        // or the other side sees us parked and notifies
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv.wait(lock, ready);
+        parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify(std::atomic<int>& parked, std::condition_variable& cv) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (0 == parked.load(std::memory_order_relaxed)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->park_mutex);
+        }
+        cv.notify_all();
+    }
+
+    static size_t roundUp(size_t value) {
+        size_t size = 2;
+        while (size < value) {
+            size <<= 1;
+        }
+        return size;
+    }
+};
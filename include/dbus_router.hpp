@@ -0,0 +1,357 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <dbus/dbus.h>
+
+#include "dbus_server_wrapper.hpp"
+#include "dbus_reply_cache.hpp"
+
+//
+// Router
+//
+// Controllers register one handler per (interface, member) pair.
+// Routes live in an open-addressing table keyed by a hash computed once at
+// registration; a request hashes its interface/member in place (no copy)
+// and compares strings only on a hash hit, so dispatch cost does not grow
+// with the number of methods.
+//
+// Every route also keeps call / error counts and a latency histogram
+// (relaxed atomics, safe to update from any worker thread). They are served
+// live by the built-in com.example.Stats.GetStats method on every router.
+//
+// Handlers registered with addPureMethod() depend on their arguments only.
+// Once enableReplyCache() is called their replies are memoized in a bounded
+// LRU (DBusReplyCache); hits / misses are served by GetCacheStats.
+//
+// An ArenaHandler also receives the calling thread's request arena, a
+// monotonic memory_resource for its temporaries (std::pmr containers). The
+// router rewinds it once the handler has built its reply (libdbus copies
+// every value into the message), so steady-state requests reuse the same
+// buffer instead of calling malloc.
+
+class DBusRouter : public IRouter {
+public:
+    using Handler = std::function<DBusMessage*(DBusMessage*)>;
+    using ArenaHandler = std::function<DBusMessage*(DBusMessage*, std::pmr::memory_resource*)>;
+
+    // Bucket 0: < 1us, bucket i: [2^(i-1), 2^i) us, last bucket: everything above
+    static constexpr size_t kLatencyBuckets = 24;
+    // Per-thread request arena (a larger request spills to the heap)
+    static constexpr size_t kArenaSize = 16 * 1024;
+
+private:
+    struct RouteStats {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> total_ns{0};
+        std::atomic<uint64_t> buckets[kLatencyBuckets] = {};
+        std::atomic<uint64_t> cache_hits{0};
+        std::atomic<uint64_t> cache_misses{0};
+    };
+    struct Route {
+        uint64_t hash;
+        std::string interface_name;
+        std::string method_name;
+        Handler handler;
+        bool pure;
+        // Heap allocated: atomics do not move when the table grows
+        std::unique_ptr<RouteStats> stats;
+    };
+private:
+    std::vector<Route> routes;
+    size_t route_count;
+    std::unique_ptr<DBusReplyCache> reply_cache;
+
+public:
+    // Constructor
+    DBusRouter() : routes(16), route_count(0)
+    {
+        this->addMethod("com.example.Stats", "GetStats",
+            [this] (DBusMessage* message) { return this->DBusRouter::getStats(message); });
+        this->addMethod("com.example.Stats", "GetCacheStats",
+            [this] (DBusMessage* message) { return this->DBusRouter::getCacheStats(message); });
+    }
+    // delete
+    DBusRouter(DBusRouter&& other) = delete;
+    DBusRouter& operator=(DBusRouter&& other) = delete;
+    DBusRouter(const DBusRouter&) = delete;
+    DBusRouter& operator=(const DBusRouter&) = delete;
+    // De-Constructor
+    ~DBusRouter() {}
+
+public:
+    // Memoize pure methods (call before serving; not thread-safe)
+    void enableReplyCache(size_t max_entries) {
+        this->reply_cache.reset(new DBusReplyCache(max_entries));
+    }
+
+    DBusMessage* handleRequest(DBusMessage* message) override {
+        // Only method calls expect a reply
+        if (DBUS_MESSAGE_TYPE_METHOD_CALL != dbus_message_get_type(message)) {
+            return nullptr;
+        }
+
+        const char* interface_name = dbus_message_get_interface(message);
+        const char* method_name = dbus_message_get_member(message);
+        const Route* route = this->DBusRouter::findRoute(interface_name, method_name);
+        if (nullptr == route) {
+            return dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_METHOD, "Method not found");
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        DBusMessage* reply = (route->pure && this->reply_cache)
+            ? this->DBusRouter::cachedCall(*route, message)
+            : route->handler(message);
+        const auto end = std::chrono::steady_clock::now();
+
+        // Reply is built: nothing in the arena is referenced any more
+        DBusRouter::requestArena().release();
+
+        DBusRouter::record(*(route->stats),
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count(),
+            nullptr == reply || DBUS_MESSAGE_TYPE_ERROR == dbus_message_get_type(reply));
+        return reply;
+    }
+
+protected:
+    // Register a handler (replaces an existing one with the same key)
+    void addMethod(const char* interface_name, const char* method_name, Handler handler) {
+        // Keep load factor <= 1/2 so probe sequences stay short
+        if (2 * (this->route_count + 1) > this->routes.size()) {
+            this->DBusRouter::grow();
+        }
+
+        const uint64_t hash = DBusRouter::hashKey(interface_name, method_name);
+        Route& slot = this->DBusRouter::probe(this->routes, hash, interface_name, method_name);
+        if (! slot.handler) {
+            ++(this->route_count);
+            slot.stats.reset(new RouteStats());
+        }
+        slot.hash = hash;
+        slot.interface_name = interface_name;
+        slot.method_name = method_name;
+        slot.handler = std::move(handler);
+        slot.pure = false;
+    }
+
+    // Handler that allocates its temporaries from the request arena
+    void addMethod(const char* interface_name, const char* method_name, ArenaHandler handler) {
+        this->DBusRouter::addMethod(interface_name, method_name,
+            [handler = std::move(handler)] (DBusMessage* message) { return handler(message, &DBusRouter::requestArena()); });
+    }
+
+    // Same as addMethod, for handlers whose reply depends on the arguments only
+    template<typename AnyHandler>
+    void addPureMethod(const char* interface_name, const char* method_name, AnyHandler handler) {
+        this->DBusRouter::addMethod(interface_name, method_name, std::move(handler));
+        Route& slot = this->DBusRouter::probe(this->routes,
+            DBusRouter::hashKey(interface_name, method_name), interface_name, method_name);
+        slot.pure = true;
+    }
+
+private:
+    static std::pmr::monotonic_buffer_resource& requestArena() {
+        alignas(std::max_align_t) thread_local std::byte buffer[kArenaSize];
+        thread_local std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::new_delete_resource());
+        return arena;
+    }
+
+    DBusMessage* cachedCall(const Route& route, DBusMessage* message) {
+        // Reused per thread: a hit allocates nothing but the reply copy
+        thread_local std::string key;
+        uint64_t hash = 0;
+        if (false == DBusReplyCache::makeKey(message, key, hash)) {
+            return route.handler(message);
+        }
+
+        DBusMessage* reply = this->reply_cache->lookup(message, key, hash);
+        if (nullptr != reply) {
+            route.stats->cache_hits.fetch_add(1, std::memory_order_relaxed);
+            return reply;
+        }
+
+        route.stats->cache_misses.fetch_add(1, std::memory_order_relaxed);
+        reply = route.handler(message);
+        this->reply_cache->store(key, hash, reply);
+        return reply;
+    }
+
+    static void record(RouteStats& stats, uint64_t elapsed_ns, bool failed) {
+        // log2 of whole microseconds
+        size_t bucket = 0;
+        for (uint64_t us = elapsed_ns / 1000; us > 0 && bucket < kLatencyBuckets - 1; us >>= 1) {
+            ++bucket;
+        }
+
+        stats.calls.fetch_add(1, std::memory_order_relaxed);
+        stats.total_ns.fetch_add(elapsed_ns, std::memory_order_relaxed);
+        stats.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        if (failed) {
+            stats.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // GetStats() -> a(sstttat)
+    // (interface, member, calls, errors, total latency ns, latency histogram)
+    DBusMessage* getStats(DBusMessage* message) const {
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        if (nullptr == reply) {
+            return nullptr;
+        }
+
+        DBusMessageIter iter, array;
+        dbus_message_iter_init_append(reply, &iter);
+        if ( false == dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "(sstttat)", &array) ) {
+            goto error;
+        }
+        for (const Route& route : this->routes) {
+            if (! route.handler) {
+                continue;
+            }
+
+            // Snapshot (counters keep moving while we read them)
+            const char* interface_name = route.interface_name.c_str();
+            const char* method_name = route.method_name.c_str();
+            const dbus_uint64_t calls = route.stats->calls.load(std::memory_order_relaxed);
+            const dbus_uint64_t errors = route.stats->errors.load(std::memory_order_relaxed);
+            const dbus_uint64_t total_ns = route.stats->total_ns.load(std::memory_order_relaxed);
+            dbus_uint64_t buckets[kLatencyBuckets];
+            for (size_t i = 0; i < kLatencyBuckets; ++i) {
+                buckets[i] = route.stats->buckets[i].load(std::memory_order_relaxed);
+            }
+            const dbus_uint64_t* bucket_data = buckets;
+
+            DBusMessageIter entry, histogram;
+            if ( false == dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, nullptr, &entry)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &interface_name)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &method_name)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &calls)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &errors)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &total_ns)
+                || false == dbus_message_iter_open_container(&entry, DBUS_TYPE_ARRAY, DBUS_TYPE_UINT64_AS_STRING, &histogram)
+                || false == dbus_message_iter_append_fixed_array(&histogram, DBUS_TYPE_UINT64, &bucket_data, kLatencyBuckets)
+                || false == dbus_message_iter_close_container(&entry, &histogram)
+                || false == dbus_message_iter_close_container(&array, &entry) ) {
+                goto error;
+            }
+        }
+        if ( false == dbus_message_iter_close_container(&iter, &array) ) {
+            goto error;
+        }
+        return reply;
+
+    error:
+        dbus_message_unref(reply);
+        return dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "Unable to build stats");
+    }
+
+    // GetCacheStats() -> a(sstt)
+    // (interface, member, hits, misses) for every pure method
+    DBusMessage* getCacheStats(DBusMessage* message) const {
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        if (nullptr == reply) {
+            return nullptr;
+        }
+
+        DBusMessageIter iter, array;
+        dbus_message_iter_init_append(reply, &iter);
+        if ( false == dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "(sstt)", &array) ) {
+            goto error;
+        }
+        for (const Route& route : this->routes) {
+            if (! route.handler || false == route.pure) {
+                continue;
+            }
+
+            const char* interface_name = route.interface_name.c_str();
+            const char* method_name = route.method_name.c_str();
+            const dbus_uint64_t hits = route.stats->cache_hits.load(std::memory_order_relaxed);
+            const dbus_uint64_t misses = route.stats->cache_misses.load(std::memory_order_relaxed);
+
+            DBusMessageIter entry;
+            if ( false == dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, nullptr, &entry)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &interface_name)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &method_name)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &hits)
+                || false == dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &misses)
+                || false == dbus_message_iter_close_container(&array, &entry) ) {
+                goto error;
+            }
+        }
+        if ( false == dbus_message_iter_close_container(&iter, &array) ) {
+            goto error;
+        }
+        return reply;
+
+    error:
+        dbus_message_unref(reply);
+        return dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "Unable to build cache stats");
+    }
+
+    const Route* findRoute(const char* interface_name, const char* method_name) const {
+        if (nullptr == interface_name || nullptr == method_name) {
+            return nullptr;
+        }
+
+        const uint64_t hash = DBusRouter::hashKey(interface_name, method_name);
+        const size_t mask = this->routes.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const Route& route = this->routes[i];
+            if (! route.handler) {
+                return nullptr;
+            }
+            if (route.hash == hash
+                && 0 == std::strcmp(route.method_name.c_str(), method_name)
+                && 0 == std::strcmp(route.interface_name.c_str(), interface_name)) {
+                return &route;
+            }
+        }
+    }
+
+    // Slot holding the key, or the empty slot where it belongs
+    static Route& probe(std::vector<Route>& table, uint64_t hash, const char* interface_name, const char* method_name) {
+        const size_t mask = table.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            Route& route = table[i];
+            if (! route.handler
+                || (route.hash == hash
+                    && route.method_name == method_name
+                    && route.interface_name == interface_name)) {
+                return route;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<Route> table(this->routes.size() * 2);
+        for (Route& route : this->routes) {
+            if (route.handler) {
+                Route& slot = DBusRouter::probe(table, route.hash, route.interface_name.c_str(), route.method_name.c_str());
+                slot = std::move(route);
+            }
+        }
+        this->routes.swap(table);
+    }
+
+    // FNV-1a over "interface\0member"
+    static uint64_t hashKey(const char* interface_name, const char* method_name) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const char* p = interface_name; *p; ++p) {
+            hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0) * 1099511628211ULL;
+        for (const char* p = method_name; *p; ++p) {
+            hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+        }
+        return hash;
+    }
+};
@@ -2,8 +2,16 @@
 
 #include <iostream>
 #include <functional>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 #include <dbus/dbus.h>
 
+#include "dbus_worker_pool.hpp"
+#include "dbus_event_loop.hpp"
+
 //
 // Interface
 //
@@ -36,6 +44,10 @@ protected:
     const char* service_name;
 protected:
     IRouter* controller;
+protected:
+    // Upper bound of messages handled per wakeup (drain mode)
+    size_t max_batch;
+    std::vector<DBusMessage*> batch_replies;
 
 public:
     // Constructor
@@ -43,7 +55,8 @@ public:
         conn(dc),
         runnable(true),
         service_name(sn),
-        controller(ctl)
+        controller(ctl),
+        max_batch(64)
     {
         dbus_error_init(&error);
 
@@ -82,27 +95,209 @@ public:
             // Blocking way
             // useful to look at
             // spec: https://dbus.freedesktop.org/doc/api/html/group__DBusConnection.html#ga580d8766c23fe5f49418bc7d87b67dc6
-            dbus_connection_read_write_dispatch(this->conn, -1);
+            // (read only: dispatching would answer queued calls with UnknownMethod;
+            //  only block when nothing is left over from the previous batch)
+            if (DBUS_DISPATCH_DATA_REMAINS != dbus_connection_get_dispatch_status(this->conn)) {
+                if ( false == dbus_connection_read_write(this->conn, this->waitTimeout()) ) {
+                    std::cerr << "Connection closed" << std::endl;
+                    return;
+                }
+            }
+
+            this->DBusServer::drainBatch();
+            this->onWakeup();
+        }
+    }
+
+    // Messages handled per wakeup (1 = one message per wakeup)
+    void setMaxBatch(size_t n) {
+        this->max_batch = (n > 0) ? n : 1;
+    }
+
+    // Serve requests on a fixed pool of threads with a bounded queue.
+    // The accept loop polls the socket itself instead of blocking inside
+    // libdbus, so replies sent from the workers can be written right away
+    // (a thread blocked in dbus_connection_read_write() holds the I/O path).
+    void runWorkerPool(size_t worker_count = std::thread::hardware_concurrency(), size_t queue_capacity = 256) {
+        // Check runnable
+        if (false == this->runnable) {
+            return;
+        }
+
+        int conn_fd = -1;
+        if ( false == dbus_connection_get_unix_fd(this->conn, &conn_fd) ) {
+            std::cerr << "Worker pool needs a unix socket connection" << std::endl;
+            return;
+        }
+
+        // Workers poke this when a reply is still queued in libdbus
+        int wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd < 0) {
+            std::cerr << "eventfd failed" << std::endl;
+            return;
+        }
+
+        {
+            WorkerPool pool(worker_count, queue_capacity);
+            std::cout << "Worker pool: " << pool.size() << " thread(s), queue " << queue_capacity << std::endl;
+
+            // Main loop
+            for (;;) {
+                struct pollfd fds[2];
+                fds[0].fd = conn_fd;
+                fds[0].events = POLLIN;
+                if (dbus_connection_has_messages_to_send(this->conn)) {
+                    fds[0].events |= POLLOUT;
+                }
+                fds[0].revents = 0;
+                fds[1].fd = wake_fd;
+                fds[1].events = POLLIN;
+                fds[1].revents = 0;
+
+                if (poll(fds, 2, this->waitTimeout()) < 0) {
+                    continue;
+                }
+                if (fds[1].revents & POLLIN) {
+                    eventfd_t value;
+                    eventfd_read(wake_fd, &value);
+                }
+
+                // Read what is available and write queued replies (no blocking)
+                if ( false == dbus_connection_read_write(this->conn, 0) ) {
+                    std::cerr << "Connection closed" << std::endl;
+                    break;
+                }
+
+                DBusMessage* message = nullptr;
+                while ( nullptr != (message = dbus_connection_pop_message(this->conn)) ) {
+                    pool.submit( [this, message, wake_fd] () {
+                        // Run session
+                        this->DBusServer::runSession(message);
+
+                        // Release Message
+                        dbus_message_unref(message);
+
+                        // Reply could not be written from this thread, or the
+                        // request left deferred work the loop has to schedule
+                        if (dbus_connection_has_messages_to_send(this->conn) || this->waitTimeout() >= 0) {
+                            eventfd_write(wake_fd, 1);
+                        }
+                    } );
+                }
+
+                this->onWakeup();
+            }
+        }
+
+        close(wake_fd);
+    }
 
+    // Serve from a shared event loop instead of a dedicated thread.
+    // Several services / connections can be attached to the same loop;
+    // the loop's run() then drives all of them from one thread.
+    bool attach(DBusEventLoop& loop) {
+        // Check runnable
+        if (false == this->runnable) {
+            return false;
+        }
+
+        if ( false == dbus_connection_add_filter(this->conn, DBusServer::onMessage, this, nullptr) ) {
+            std::cerr << "dbus_connection_add_filter failed" << std::endl;
+            return false;
+        }
+        if ( false == loop.addConnection(this->conn) ) {
+            dbus_connection_remove_filter(this->conn, DBusServer::onMessage, this);
+            std::cerr << "Unable to attach connection to event loop" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Filter installed by attach(): method calls go to the controller
+    static DBusHandlerResult onMessage(DBusConnection* /*dc*/, DBusMessage* message, void* user_data) {
+        if (DBUS_MESSAGE_TYPE_METHOD_CALL != dbus_message_get_type(message)) {
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+        static_cast<DBusServer*>(user_data)->runSession(message);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
+protected:
+    // Hooks for run() / runWorkerPool(): wait at most waitTimeout() ms for
+    // traffic (-1 = forever), onWakeup() is called after every wakeup, whether
+    // messages came in or not. Lets a service do deferred work (e.g. coalesced
+    // signals) on the loop thread. With the worker pool, waitTimeout() is also
+    // called from workers and has to be thread-safe.
+    virtual int waitTimeout() {
+        return -1;
+    }
+    virtual void onWakeup() {}
+    // Called after requests were handled and before their replies are sent
+    // (once per drained batch, once per request on the other paths), e.g. to
+    // make the batch's writes durable with a single sync. Returning false
+    // turns every method return of the batch into a Failed error: nothing
+    // the batch did is acknowledged.
+    virtual bool onBatchEnd() {
+        return true;
+    }
+
+protected:
+    // Drain mode: handle every queued message (up to max_batch), pulling more
+    // from the socket without blocking, then send all replies and flush once.
+    // Returns the number of messages handled.
+    size_t drainBatch() {
+        size_t handled = 0;
+        while (handled < this->max_batch) {
             DBusMessage* message = dbus_connection_pop_message(this->conn);
             if (nullptr == message) {
-                continue;
+                // Queue is empty; see whether more of the burst has arrived
+                if ( false == dbus_connection_read_write(this->conn, 0)
+                    || nullptr == (message = dbus_connection_pop_message(this->conn)) ) {
+                    break;
+                }
             }
 
-            DBusMessage* reply = controller->handleRequest(message);
+            DBusMessage* reply = this->controller->handleRequest(message);
             if (nullptr != reply) {
-                dbus_connection_send(this->conn, reply, nullptr);
-                dbus_message_unref(reply);
+                this->batch_replies.push_back(reply);
             }
-
             dbus_message_unref(message);
+            ++handled;
+        }
+
+        if (handled > 0 && false == this->onBatchEnd()) {
+            std::vector<DBusMessage*> failed;
+            for (DBusMessage* reply : this->batch_replies) {
+                if ( nullptr != (reply = DBusServer::failReply(reply)) ) {
+                    failed.push_back(reply);
+                }
+            }
+            this->batch_replies.swap(failed);
         }
+        if (this->batch_replies.empty()) {
+            return handled;
+        }
+
+        // Send replies
+        for (DBusMessage* reply : this->batch_replies) {
+            dbus_connection_send(this->conn, reply, nullptr);
+            dbus_message_unref(reply);
+        }
+        this->batch_replies.clear();
+
+        // One flush for the whole batch
+        dbus_connection_flush(this->conn);
+        return handled;
     }
 
 protected:
     void runSession(DBusMessage* message) override {
         // Generate response
         DBusMessage* reply = controller->handleRequest(message);
+        if (false == this->onBatchEnd() && nullptr != reply) {
+            reply = DBusServer::failReply(reply);
+        }
         if (nullptr == reply) {
             return;
         }
@@ -113,4 +308,27 @@ protected:
         // Release reply
         dbus_message_unref(reply);
     }
+
+private:
+    // Replace a method return with a Failed error to the same caller (takes
+    // the reply; errors pass through). nullptr if out of memory: no answer
+    // is better than a false one, the caller gets NoReply.
+    static DBusMessage* failReply(DBusMessage* reply) {
+        if (DBUS_MESSAGE_TYPE_METHOD_RETURN != dbus_message_get_type(reply)) {
+            return reply;
+        }
+
+        const char* text = "Unable to commit the request";
+        DBusMessage* error = dbus_message_new(DBUS_MESSAGE_TYPE_ERROR);
+        if ( error
+            && ( false == dbus_message_set_error_name(error, DBUS_ERROR_FAILED)
+                || false == dbus_message_set_reply_serial(error, dbus_message_get_reply_serial(reply))
+                || false == dbus_message_set_destination(error, dbus_message_get_destination(reply))
+                || false == dbus_message_append_args(error, DBUS_TYPE_STRING, &text, DBUS_TYPE_INVALID) ) ) {
+            dbus_message_unref(error);
+            error = nullptr;
+        }
+        dbus_message_unref(reply);
+        return error;
+    }
 };
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Worker Pool
+//
+// Fixed number of threads fed by a bounded FIFO queue.
+// submit() blocks while the queue is full, so a burst of requests
+// pushes back on the accept loop instead of growing memory.
+
+class WorkerPool {
+private:
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::function<void()>> tasks;
+    size_t capacity;
+    bool stopping;
+private:
+    std::vector<std::thread> workers;
+
+public:
+    // Constructor
+    WorkerPool(size_t worker_count, size_t queue_capacity) :
+        capacity(queue_capacity > 0 ? queue_capacity : 1),
+        stopping(false)
+    {
+        if (0 == worker_count) {
+            worker_count = 1;
+        }
+        workers.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers.emplace_back( [this] () { this->WorkerPool::work(); } );
+        }
+    }
+    // delete
+    WorkerPool() = delete;
+    WorkerPool(WorkerPool&& other) = delete;
+    WorkerPool& operator=(WorkerPool&& other) = delete;
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    // De-Constructor (finish queued tasks, then join)
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+public:
+    // Queue a task (blocks while the queue is full); false after shutdown
+    bool submit(std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this] () { return stopping || tasks.size() < capacity; });
+            if (stopping) {
+                return false;
+            }
+            tasks.push_back(std::move(task));
+        }
+        not_empty.notify_one();
+        return true;
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [this] () { return stopping || false == tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            not_full.notify_one();
+
+            task();
+        }
+    }
+};
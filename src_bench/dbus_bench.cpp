@@ -0,0 +1,524 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "../include/dbus_conn_wrapper.hpp"
+#include "../include/dbus_args.hpp"
+
+//
+// Private bus
+//
+// dbus-daemon --session --nofork --print-address, owned by the benchmark
+// so results never depend on (or disturb) the desktop session bus.
+// Set DBUS_DAEMON to use another binary.
+
+class PrivateBus {
+private:
+    pid_t pid;
+    std::string address;
+
+public:
+    // Constructor
+    PrivateBus() : pid(-1)
+    {
+        const char* daemon = std::getenv("DBUS_DAEMON");
+        if (nullptr == daemon || '\0' == *daemon) {
+            daemon = "dbus-daemon";
+        }
+
+        int fds[2];
+        if (0 != pipe(fds)) {
+            std::cerr << "pipe: " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        this->pid = fork();
+        if (0 == this->pid) {
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            execlp(daemon, daemon, "--session", "--nofork", "--print-address", static_cast<char*>(nullptr));
+            std::cerr << "exec " << daemon << ": " << std::strerror(errno) << std::endl;
+            _exit(127);
+        }
+        close(fds[1]);
+        if (this->pid < 0) {
+            std::cerr << "fork: " << std::strerror(errno) << std::endl;
+            close(fds[0]);
+            return;
+        }
+
+        // First line is the address
+        char c;
+        while (1 == read(fds[0], &c, 1) && '\n' != c) {
+            this->address.push_back(c);
+        }
+        close(fds[0]);
+        if (this->address.empty()) {
+            std::cerr << "dbus-daemon did not report an address" << std::endl;
+        }
+    }
+    // delete
+    PrivateBus(PrivateBus&& other) = delete;
+    PrivateBus& operator=(PrivateBus&& other) = delete;
+    PrivateBus(const PrivateBus&) = delete;
+    PrivateBus& operator=(const PrivateBus&) = delete;
+    // De-Constructor
+    ~PrivateBus() {
+        if (this->pid > 0) {
+            kill(this->pid, SIGTERM);
+            waitpid(this->pid, nullptr, 0);
+        }
+    }
+
+public:
+    bool isRunning() const {
+        return this->pid > 0 && false == this->address.empty();
+    }
+
+    const std::string& getAddress() const {
+        return this->address;
+    }
+};
+
+//
+// Service process
+//
+// Runs a service binary against the private bus (stdout discarded, so
+// per-request logging does not end up in the measurement output).
+
+class ServiceProcess {
+private:
+    pid_t pid;
+
+public:
+    // Constructor
+    ServiceProcess(const std::string& binary, const std::string& bus_address) : pid(-1)
+    {
+        this->pid = fork();
+        if (0 == this->pid) {
+            setenv("DBUS_SESSION_BUS_ADDRESS", bus_address.c_str(), 1);
+            setenv("DBUS_BUS_TYPE", "session", 1);
+            unsetenv("DBUS_PEER_ADDRESS");
+            int null_fd = open("/dev/null", O_WRONLY);
+            if (null_fd >= 0) {
+                dup2(null_fd, STDOUT_FILENO);
+                close(null_fd);
+            }
+            execl(binary.c_str(), binary.c_str(), static_cast<char*>(nullptr));
+            std::cerr << "exec " << binary << ": " << std::strerror(errno) << std::endl;
+            _exit(127);
+        }
+        if (this->pid < 0) {
+            std::cerr << "fork: " << std::strerror(errno) << std::endl;
+        }
+    }
+    // delete
+    ServiceProcess() = delete;
+    ServiceProcess(ServiceProcess&& other) = delete;
+    ServiceProcess& operator=(ServiceProcess&& other) = delete;
+    ServiceProcess(const ServiceProcess&) = delete;
+    ServiceProcess& operator=(const ServiceProcess&) = delete;
+    // De-Constructor
+    ~ServiceProcess() {
+        if (this->pid > 0) {
+            kill(this->pid, SIGTERM);
+            waitpid(this->pid, nullptr, 0);
+        }
+    }
+
+public:
+    bool isRunning() const {
+        return this->pid > 0 && 0 == waitpid(this->pid, nullptr, WNOHANG);
+    }
+};
+
+//
+// Scenarios
+//
+
+struct Scenario {
+    const char* service;
+    const char* model;
+    const char* binary;
+    const char* bus_name;
+    const char* object_path;
+    const char* interface_name;
+    const char* method;
+    // append the call arguments (false on OOM)
+    std::function<bool(DBusMessage*)> appendArgs;
+};
+
+static std::vector<Scenario> makeScenarios() {
+    auto hello = [] (DBusMessage* message) {
+        return DBusArgs<const char*>::append(message, "World");
+    };
+    auto add = [] (DBusMessage* message) {
+        return DBusArgs<int32_t, int32_t>::append(message, 20, 22);
+    };
+
+    const char* hello_name = "com.example.HelloService";
+    const char* hello_path = "/com/example/HelloService";
+    const char* hello_iface = "com.example.HelloInterface";
+    return {
+        { "hello", "BLOCK_ACCEPT",  "hello_service_block_accept",  hello_name, hello_path, hello_iface, "Hello", hello },
+        { "hello", "ASYNC_ACCEPT",  "hello_service_async_accept",  hello_name, hello_path, hello_iface, "Hello", hello },
+        { "hello", "THREAD_ACCEPT", "hello_service_thread_accept", hello_name, hello_path, hello_iface, "Hello", hello },
+        { "hello", "WORKER_POOL",   "hello_service_worker_pool",   hello_name, hello_path, hello_iface, "Hello", hello },
+        { "hello", "EVENT_LOOP",    "hello_service_event_loop",    hello_name, hello_path, hello_iface, "Hello", hello },
+        { "calculator", "BLOCK_ACCEPT", "calculator_service",
+          "com.example.CalcService", "/com/example/CalcService", "com.example.CalcInterface", "Add", add },
+    };
+}
+
+//
+// Measurement
+//
+
+struct Options {
+    std::vector<int> concurrency = { 1, 4, 16 };
+    int duration_ms = 2000;
+    int warmup_calls = 100;
+    int timeout_ms = 1000;
+    std::string bin_dir;
+    std::string output = "bench.json";
+    std::string filter;
+};
+
+struct Result {
+    const Scenario* scenario;
+    int concurrency;
+    uint64_t calls;
+    uint64_t errors;
+    double seconds;
+    double calls_per_sec;
+    double p50_us;
+    double p99_us;
+    double p999_us;
+};
+
+// Nearest-rank percentile over sorted samples (ns -> us)
+static double percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+    rank = std::min(std::max(rank, size_t(1)), sorted.size());
+    return sorted[rank - 1] / 1000.0;
+}
+
+// One private bus connection per client thread (a shared connection would
+// serialize the callers on its I/O lock and measure that instead)
+static DBusConnection* openClient(DBusConn& dbus_conn) {
+    DBusConnection* conn = dbus_conn.getConn();
+    if (nullptr == conn) {
+        return nullptr;
+    }
+
+    DBusError error;
+    dbus_error_init(&error);
+    if ( false == dbus_bus_register(conn, &error) ) {
+        std::cerr << error.name << std::endl << error.message << std::endl;
+        dbus_error_free(&error);
+        return nullptr;
+    }
+    return conn;
+}
+
+// A call that times out counts as an error (e.g. THREAD_ACCEPT replies can
+// sit in the outgoing queue until the next request wakes the service up)
+static bool callOnce(DBusConnection* conn, const Scenario& scenario, int timeout_ms) {
+    DBusMessage* message = dbus_message_new_method_call(
+        scenario.bus_name, scenario.object_path, scenario.interface_name, scenario.method);
+    if (nullptr == message) {
+        return false;
+    }
+    if ( false == scenario.appendArgs(message) ) {
+        dbus_message_unref(message);
+        return false;
+    }
+
+    DBusError error;
+    dbus_error_init(&error);
+    DBusMessage* reply = dbus_connection_send_with_reply_and_block(conn, message, timeout_ms, &error);
+    dbus_message_unref(message);
+    if (nullptr == reply) {
+        dbus_error_free(&error);
+        return false;
+    }
+    const bool ok = (DBUS_MESSAGE_TYPE_METHOD_RETURN == dbus_message_get_type(reply));
+    dbus_message_unref(reply);
+    return ok;
+}
+
+// Poll until the name is (owned) / (released)
+static bool waitForName(DBusConnection* conn, const char* name, bool owned, std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (owned == static_cast<bool>(dbus_bus_name_has_owner(conn, name, nullptr))) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+static Result runLoad(const std::string& bus_address, const Scenario& scenario, int concurrency, const Options& options) {
+    std::vector<std::vector<uint64_t>> latencies(concurrency);
+    std::vector<uint64_t> errors(concurrency, 0);
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<bool> stop(false);
+
+    std::vector<std::thread> clients;
+    for (int i = 0; i < concurrency; ++i) {
+        clients.emplace_back( [&, i] () {
+            DBusConn dbus_conn(bus_address.c_str());
+            DBusConnection* conn = openClient(dbus_conn);
+
+            // Warm up (connection setup, first-call allocations on both sides),
+            // bounded by the run duration so a stalling model cannot hang the suite
+            const auto warmup_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.duration_ms);
+            for (int n = 0; conn && n < options.warmup_calls && std::chrono::steady_clock::now() < warmup_end; ++n) {
+                callOnce(conn, scenario, options.timeout_ms);
+            }
+            latencies[i].reserve(1 << 16);
+
+            ++ready;
+            while (false == go.load()) {
+                std::this_thread::yield();
+            }
+            if (nullptr == conn) {
+                errors[i] = 1;
+                return;
+            }
+
+            while (false == stop.load(std::memory_order_relaxed)) {
+                const auto begin = std::chrono::steady_clock::now();
+                const bool ok = callOnce(conn, scenario, options.timeout_ms);
+                const auto end = std::chrono::steady_clock::now();
+                if (ok) {
+                    latencies[i].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+                } else {
+                    ++errors[i];
+                }
+            }
+        } );
+    }
+
+    while (ready.load() < concurrency) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto begin = std::chrono::steady_clock::now();
+    go = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.duration_ms));
+    stop = true;
+    for (auto& client : clients) {
+        client.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    // Merge
+    std::vector<uint64_t> all;
+    Result result = {};
+    result.scenario = &scenario;
+    result.concurrency = concurrency;
+    for (int i = 0; i < concurrency; ++i) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+        result.errors += errors[i];
+    }
+    std::sort(all.begin(), all.end());
+
+    result.calls = all.size();
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.calls_per_sec = result.seconds > 0 ? result.calls / result.seconds : 0.0;
+    result.p50_us = percentile(all, 50.0);
+    result.p99_us = percentile(all, 99.0);
+    result.p999_us = percentile(all, 99.9);
+    return result;
+}
+
+//
+// Report
+//
+
+static std::string toJson(const std::vector<Result>& results, const Options& options) {
+    std::ostringstream out;
+    out << "{\n";
+    out << "  \"benchmark\": \"dbus_bench\",\n";
+    out << "  \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() << ",\n";
+    out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"duration_ms\": " << options.duration_ms << ",\n";
+    out << "  \"warmup_calls\": " << options.warmup_calls << ",\n";
+    out << "  \"timeout_ms\": " << options.timeout_ms << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (0 == i ? "\n" : ",\n");
+        out << "    { \"service\": \"" << r.scenario->service << "\""
+            << ", \"model\": \"" << r.scenario->model << "\""
+            << ", \"method\": \"" << r.scenario->method << "\""
+            << ", \"concurrency\": " << r.concurrency
+            << ", \"calls\": " << r.calls
+            << ", \"errors\": " << r.errors
+            << ", \"seconds\": " << r.seconds
+            << ", \"calls_per_sec\": " << r.calls_per_sec
+            << ", \"latency_us\": { \"p50\": " << r.p50_us
+            << ", \"p99\": " << r.p99_us
+            << ", \"p99.9\": " << r.p999_us << " } }";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+//
+// main
+//
+
+static void usage(const char* self) {
+    std::cerr << "Usage: " << self << " [options]" << std::endl
+              << "  --concurrency=1,4,16   client threads per run (comma separated)" << std::endl
+              << "  --duration-ms=2000     measured time per run" << std::endl
+              << "  --warmup=100           unmeasured calls per client before each run" << std::endl
+              << "  --timeout-ms=1000      per call timeout (counted as an error)" << std::endl
+              << "  --only=<text>          run scenarios whose service/model contains <text>" << std::endl
+              << "  --bin-dir=<dir>        where the service binaries are (default: next to this binary)" << std::endl
+              << "  --output=bench.json    JSON report path ('-' for stdout)" << std::endl;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&arg] (const char* key) -> const char* {
+            const size_t len = std::strlen(key);
+            return (0 == arg.compare(0, len, key)) ? arg.c_str() + len : nullptr;
+        };
+
+        const char* v = nullptr;
+        if ( nullptr != (v = value("--concurrency=")) ) {
+            options.concurrency.clear();
+            std::stringstream list(v);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                const int n = std::atoi(item.c_str());
+                if (n <= 0) {
+                    return false;
+                }
+                options.concurrency.push_back(n);
+            }
+        } else if ( nullptr != (v = value("--duration-ms=")) ) {
+            options.duration_ms = std::atoi(v);
+        } else if ( nullptr != (v = value("--warmup=")) ) {
+            options.warmup_calls = std::atoi(v);
+        } else if ( nullptr != (v = value("--timeout-ms=")) ) {
+            options.timeout_ms = std::atoi(v);
+        } else if ( nullptr != (v = value("--only=")) ) {
+            options.filter = v;
+        } else if ( nullptr != (v = value("--bin-dir=")) ) {
+            options.bin_dir = v;
+        } else if ( nullptr != (v = value("--output=")) ) {
+            options.output = v;
+        } else {
+            return false;
+        }
+    }
+    return false == options.concurrency.empty() && options.duration_ms > 0 && options.warmup_calls >= 0 && options.timeout_ms > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (false == parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (options.bin_dir.empty()) {
+        char self[4096] = {};
+        if (readlink("/proc/self/exe", self, sizeof(self) - 1) > 0) {
+            options.bin_dir = self;
+            options.bin_dir.erase(options.bin_dir.find_last_of('/'));
+        } else {
+            options.bin_dir = ".";
+        }
+    }
+
+    // Thread-safe libdbus before any connection exists
+    dbus_threads_init_default();
+
+    // Private bus
+    PrivateBus bus;
+    if (false == bus.isRunning()) {
+        return 1;
+    }
+    DBusConn control(bus.getAddress().c_str());
+    if (nullptr == openClient(control)) {
+        return 1;
+    }
+    std::cerr << "bus: " << bus.getAddress() << std::endl;
+
+    const std::vector<Scenario> scenarios = makeScenarios();
+    std::vector<Result> results;
+    for (const Scenario& scenario : scenarios) {
+        const std::string label = std::string(scenario.service) + "/" + scenario.model;
+        if (false == options.filter.empty()
+            && std::string::npos == label.find(options.filter)) {
+            continue;
+        }
+
+        {
+            ServiceProcess service(options.bin_dir + "/" + scenario.binary, bus.getAddress());
+            if ( false == waitForName(control.getConn(), scenario.bus_name, true, std::chrono::seconds(5)) ) {
+                std::cerr << label << ": service did not come up, skipped" << std::endl;
+                continue;
+            }
+
+            for (int concurrency : options.concurrency) {
+                Result result = runLoad(bus.getAddress(), scenario, concurrency, options);
+                std::cerr << label << " x" << concurrency
+                          << ": " << static_cast<uint64_t>(result.calls_per_sec) << " calls/s"
+                          << ", p50 " << result.p50_us << "us"
+                          << ", p99 " << result.p99_us << "us"
+                          << ", p99.9 " << result.p999_us << "us"
+                          << ", errors " << result.errors << std::endl;
+                results.push_back(result);
+
+                if (false == service.isRunning()) {
+                    std::cerr << label << ": service exited" << std::endl;
+                    break;
+                }
+            }
+        }
+
+        // Name must be free before the next model starts
+        waitForName(control.getConn(), scenario.bus_name, false, std::chrono::seconds(5));
+    }
+
+    const std::string json = toJson(results, options);
+    if ("-" == options.output) {
+        std::cout << json;
+    } else {
+        std::ofstream file(options.output);
+        if (false == file.good()) {
+            std::cerr << "Unable to write " << options.output << std::endl;
+            return 1;
+        }
+        file << json;
+        std::cerr << "report: " << options.output << std::endl;
+    }
+    return 0;
+}
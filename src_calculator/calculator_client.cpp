@@ -1,10 +1,20 @@
 #include <iostream>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "../include/dbus_conn_wrapper.hpp"
+#include "../include/dbus_call_batch.hpp"
 #include "../include/dbus_client_wrapper.hpp"
+#include "../include/dbus_dispatcher.hpp"
+#include "../include/dbus_args.hpp"
+#include "calculator_memfd.hpp"
 
 class CalculatorClient : public DBusClient {
 private:
@@ -38,18 +48,7 @@ public:
             this->interface_name,
             "Add",
             [&a, &b] (DBusMessage* method_call) {
-                if ( false == dbus_message_append_args(
-                    method_call,
-                    DBUS_TYPE_INT32,
-                    &a,
-                    DBUS_TYPE_INT32,
-                    &b,
-                    DBUS_TYPE_INVALID)
-                    ) {
-                    std::cerr << "ERROR: dbus_message_append_args - Unable to append arguments!" << std::endl;
-                    return false;
-                }
-                return true;
+                return CalculatorClient::checkAppended(DBusArgs<int32_t, int32_t>::append(method_call, a, b));
             },
             [this, &callback] (DBusMessage* reply) {
                 this->CalculatorClient::parseAdd(reply, callback);
@@ -65,18 +64,7 @@ public:
             this->interface_name,
             "Multiply",
             [&a, &b] (DBusMessage* method_call) {
-                if ( false == dbus_message_append_args(
-                    method_call,
-                    DBUS_TYPE_DOUBLE,
-                    &a,
-                    DBUS_TYPE_DOUBLE,
-                    &b,
-                    DBUS_TYPE_INVALID)
-                    ) {
-                    std::cerr << "ERROR: dbus_message_append_args - Unable to append arguments!" << std::endl;
-                    return false;
-                }
-                return true;
+                return CalculatorClient::checkAppended(DBusArgs<double, double>::append(method_call, a, b));
             },
             [this, &callback] (DBusMessage* reply) {
                 this->CalculatorClient::parseMultiply(reply, callback);
@@ -92,18 +80,7 @@ public:
             this->interface_name,
             "Concatenate",
             [&s1, &s2] (DBusMessage* method_call) {
-                if ( false == dbus_message_append_args(
-                    method_call,
-                    DBUS_TYPE_STRING,
-                    &s1,
-                    DBUS_TYPE_STRING,
-                    &s2,
-                    DBUS_TYPE_INVALID)
-                    ) {
-                    std::cerr << "ERROR: dbus_message_append_args - Unable to append arguments!" << std::endl;
-                    return false;
-                }
-                return true;
+                return CalculatorClient::checkAppended(DBusArgs<const char*, const char*>::append(method_call, s1, s2));
             },
             [this, &callback] (DBusMessage* reply) {
                 this->CalculatorClient::parseConcatenate(reply, callback);
@@ -119,20 +96,7 @@ public:
             this->interface_name,
             "ProcessData",
             [&name, &age, &salary] (DBusMessage* method_call) {
-                if ( false == dbus_message_append_args(
-                    method_call,
-                    DBUS_TYPE_STRING,
-                    &name,
-                    DBUS_TYPE_INT32,
-                    &age,
-                    DBUS_TYPE_DOUBLE,
-                    &salary,
-                    DBUS_TYPE_INVALID)
-                    ) {
-                    std::cerr << "ERROR: dbus_message_append_args - Unable to append arguments!" << std::endl;
-                    return false;
-                }
-                return true;
+                return CalculatorClient::checkAppended(DBusArgs<const char*, int32_t, double>::append(method_call, name, age, salary));
             },
             [this, &callback] (DBusMessage* reply) {
                 this->CalculatorClient::parseProcessData(reply, callback);
@@ -140,101 +104,341 @@ public:
         );
     }
 
+    // AddArrays(ai a, ai b) -> ai
+    // (the result view points into the reply, valid during the callback)
+    void callAddArrays(const std::vector<int32_t>& a, const std::vector<int32_t>& b,
+                       const std::function<void(const DBusFixedArray<int32_t>&)>& callback = nullptr) {
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "AddArrays",
+            [&a, &b] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<DBusFixedArray<int32_t>, DBusFixedArray<int32_t>>::append(method_call,
+                    DBusFixedArray<int32_t>{ a.data(), a.size() }, DBusFixedArray<int32_t>{ b.data(), b.size() }));
+            },
+            [&callback] (DBusMessage* reply) {
+                CalculatorClient::parseArray<int32_t>(reply, callback);
+            }
+        );
+    }
+
+    // MultiplyArrays(ad a, ad b) -> ad
+    void callMultiplyArrays(const std::vector<double>& a, const std::vector<double>& b,
+                            const std::function<void(const DBusFixedArray<double>&)>& callback = nullptr) {
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "MultiplyArrays",
+            [&a, &b] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<DBusFixedArray<double>, DBusFixedArray<double>>::append(method_call,
+                    DBusFixedArray<double>{ a.data(), a.size() }, DBusFixedArray<double>{ b.data(), b.size() }));
+            },
+            [&callback] (DBusMessage* reply) {
+                CalculatorClient::parseArray<double>(reply, callback);
+            }
+        );
+    }
+
+    // Dot(ad a, ad b) -> d
+    void callDot(const std::vector<double>& a, const std::vector<double>& b, const std::function<void(double)>& callback = nullptr) {
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "Dot",
+            [&a, &b] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<DBusFixedArray<double>, DBusFixedArray<double>>::append(method_call,
+                    DBusFixedArray<double>{ a.data(), a.size() }, DBusFixedArray<double>{ b.data(), b.size() }));
+            },
+            [this, &callback] (DBusMessage* reply) {
+                this->CalculatorClient::parseMultiply(reply, callback);
+            }
+        );
+    }
+
+    // Sum(ad a) -> d
+    void callSum(const std::vector<double>& a, const std::function<void(double)>& callback = nullptr) {
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "Sum",
+            [&a] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<DBusFixedArray<double>>::append(method_call,
+                    DBusFixedArray<double>{ a.data(), a.size() }));
+            },
+            [this, &callback] (DBusMessage* reply) {
+                this->CalculatorClient::parseMultiply(reply, callback);
+            }
+        );
+    }
+
+    // SumFd(h input) -> d
+    // (input: a sealed MemfdBuffer, see MemfdBuffer::create / seal)
+    void callSumFd(const MemfdBuffer& input, const std::function<void(double)>& callback = nullptr) {
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "SumFd",
+            [this, &input] (DBusMessage* method_call) {
+                return this->CalculatorClient::checkCanSendFd()
+                    && CalculatorClient::checkAppended(DBusArgs<DBusUnixFd>::append(method_call, DBusUnixFd{ input.getFd() }));
+            },
+            [this, &callback] (DBusMessage* reply) {
+                this->CalculatorClient::parseMultiply(reply, callback);
+            }
+        );
+    }
+
+    // ScaleFd(h input, d factor) -> h
+    // (the result buffer is mapped read-only for the callback, then released)
+    void callScaleFd(const MemfdBuffer& input, double factor, const std::function<void(const MemfdBuffer&)>& callback = nullptr) {
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "ScaleFd",
+            [this, &input, &factor] (DBusMessage* method_call) {
+                return this->CalculatorClient::checkCanSendFd()
+                    && CalculatorClient::checkAppended(DBusArgs<DBusUnixFd, double>::append(method_call, DBusUnixFd{ input.getFd() }, factor));
+            },
+            [&callback] (DBusMessage* reply) {
+                CalculatorClient::parseMemfd(reply, callback);
+            }
+        );
+    }
+
+public:
+    //
+    // Non-blocking versions (call waitPending() to collect the replies)
+    //
+
+    // Add(int a, int b) -> int
+    std::future<bool> callAddAsync(int a, int b, const std::function<void(int)>& callback = nullptr) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "Add",
+            [&a, &b] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<int32_t, int32_t>::append(method_call, a, b));
+            },
+            [this, callback] (DBusMessage* reply) {
+                this->CalculatorClient::parseAdd(reply, callback);
+            }
+        );
+    }
+
+    // Multiply(double a, double b) -> double
+    std::future<bool> callMultiplyAsync(double a, double b, const std::function<void(double)>& callback = nullptr) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "Multiply",
+            [&a, &b] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<double, double>::append(method_call, a, b));
+            },
+            [this, callback] (DBusMessage* reply) {
+                this->CalculatorClient::parseMultiply(reply, callback);
+            }
+        );
+    }
+
+    // Concatenate(string s1, string s2) -> string
+    std::future<bool> callConcatenateAsync(const char* s1, const char* s2, const std::function<void(const std::string&)>& callback = nullptr) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "Concatenate",
+            [&s1, &s2] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<const char*, const char*>::append(method_call, s1, s2));
+            },
+            [this, callback] (DBusMessage* reply) {
+                this->CalculatorClient::parseConcatenate(reply, callback);
+            }
+        );
+    }
+
+    // ProcessData(string name, int age, double salary) -> string
+    std::future<bool> callProcessDataAsync(const char* name, int age, double salary, const std::function<void(const std::string&)>& callback = nullptr) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "ProcessData",
+            [&name, &age, &salary] (DBusMessage* method_call) {
+                return CalculatorClient::checkAppended(DBusArgs<const char*, int32_t, double>::append(method_call, name, age, salary));
+            },
+            [this, callback] (DBusMessage* reply) {
+                this->CalculatorClient::parseProcessData(reply, callback);
+            }
+        );
+    }
+
+public:
+    //
+    // Batch versions (all calls written at once, one overall timeout)
+    //
+
+    // Add(first, second) for every pair; callback gets (index, result) in order.
+    // Returns the number of failed calls.
+    size_t callAddBatch(
+        const std::vector<std::pair<int32_t, int32_t>>& operands,
+        int timeout_ms,
+        const std::function<void(size_t, int)>& callback = nullptr)
+    {
+        DBusCallBatch batch(this->conn, this->dispatcher);
+        for (size_t i = 0; i < operands.size(); ++i) {
+            batch.add(
+                this->service_name,
+                this->object_path,
+                this->interface_name,
+                "Add",
+                [&operands, i] (DBusMessage* method_call) {
+                    return CalculatorClient::checkAppended(
+                        DBusArgs<int32_t, int32_t>::append(method_call, operands[i].first, operands[i].second));
+                },
+                [this, i, &callback] (DBusMessage* reply) {
+                    this->CalculatorClient::parseAdd(reply, [i, &callback] (int result) {
+                        if (callback) {
+                            callback(i, result);
+                        }
+                    });
+                }
+            );
+        }
+        batch.run(timeout_ms);
+        return CalculatorClient::countFailed(batch);
+    }
+
+private:
+    // Failed calls of a batch (the first error is printed)
+    static size_t countFailed(const DBusCallBatch& batch) {
+        size_t failed = 0;
+        for (const DBusCallBatch::Result& result : batch.results()) {
+            if (result.ok()) {
+                continue;
+            }
+            if (0 == failed) {
+                std::cerr << result.error_name << std::endl << result.error_message << std::endl;
+            }
+            ++failed;
+        }
+        return failed;
+    }
+
+
+    // Report result of appending arguments
+    static bool checkAppended(bool appended) {
+        if ( false == appended ) {
+            std::cerr << "ERROR: Unable to append arguments!" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // File descriptors need a unix socket transport that negotiated fd passing
+    bool checkCanSendFd() const {
+        if ( false == dbus_connection_can_send_type(this->conn, DBUS_TYPE_UNIX_FD) ) {
+            std::cerr << "ERROR: Connection cannot pass file descriptors!" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Report unexpected reply signature
+    template<typename... Ts>
+    static bool checkParsed(DBusMessage* reply, bool parsed) {
+        if ( false == parsed ) {
+            const char* got = dbus_message_get_signature(reply);
+            std::cerr << "ERROR: Unexpected reply signature \"" << (got ? got : "")
+                      << "\", expected \"" << DBusArgs<Ts...>::signature() << "\"" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
 private:
     // Parse Add response
     void parseAdd(DBusMessage* reply, const std::function<void(int)>& callback) {
-        DBusError error;
-        dbus_error_init(&error);
-
-        int result;
-        if ( false == dbus_message_get_args(
-            reply,
-            &error,
-            DBUS_TYPE_INT32,
-            &result,
-            DBUS_TYPE_INVALID)
-            ) {
-            std::cerr << error.name << std::endl << error.message << std::endl;
-            dbus_error_free(&error);
+        int32_t result;
+        if ( false == CalculatorClient::checkParsed<int32_t>(reply, DBusArgs<int32_t>::read(reply, result)) ) {
             return;
         }
 
         if (callback) {
             callback(result);
         }
-        dbus_error_free(&error);
     }
 
-    // Parse Multiply response
+    // Parse Multiply response (also any single double: Dot, Sum)
     void parseMultiply(DBusMessage* reply, const std::function<void(double)>& callback) {
-        DBusError error;
-        dbus_error_init(&error);
-
         double result;
-        if ( false == dbus_message_get_args(
-            reply,
-            &error,
-            DBUS_TYPE_DOUBLE,
-            &result,
-            DBUS_TYPE_INVALID)
-            ) {
-            std::cerr << error.name << std::endl << error.message << std::endl;
-            dbus_error_free(&error);
+        if ( false == CalculatorClient::checkParsed<double>(reply, DBusArgs<double>::read(reply, result)) ) {
             return;
         }
 
         if (callback) {
             callback(result);
         }
-        dbus_error_free(&error);
     }
 
     // Parse Concatenate response
     void parseConcatenate(DBusMessage* reply, const std::function<void(const std::string&)>& callback) {
-        DBusError error;
-        dbus_error_init(&error);
-
         const char* result;
-        if ( false == dbus_message_get_args(
-            reply,
-            &error,
-            DBUS_TYPE_STRING,
-            &result,
-            DBUS_TYPE_INVALID)
-            ) {
-            std::cerr << error.name << std::endl << error.message << std::endl;
-            dbus_error_free(&error);
+        if ( false == CalculatorClient::checkParsed<const char*>(reply, DBusArgs<const char*>::read(reply, result)) ) {
             return;
         }
 
         if (callback) {
             callback(std::string(result));
         }
-        dbus_error_free(&error);
+    }
+
+    // Parse AddArrays / MultiplyArrays response
+    template<typename T>
+    static void parseArray(DBusMessage* reply, const std::function<void(const DBusFixedArray<T>&)>& callback) {
+        DBusFixedArray<T> result;
+        if ( false == CalculatorClient::checkParsed<DBusFixedArray<T>>(reply, DBusArgs<DBusFixedArray<T>>::read(reply, result)) ) {
+            return;
+        }
+
+        if (callback) {
+            callback(result);
+        }
+    }
+
+    // Parse ScaleFd response (takes ownership of the received fd)
+    static void parseMemfd(DBusMessage* reply, const std::function<void(const MemfdBuffer&)>& callback) {
+        DBusUnixFd result;
+        if ( false == CalculatorClient::checkParsed<DBusUnixFd>(reply, DBusArgs<DBusUnixFd>::read(reply, result)) ) {
+            return;
+        }
+
+        MemfdBuffer output;
+        if ( false == output.open(result.fd) ) {
+            return;
+        }
+        if (callback) {
+            callback(output);
+        }
     }
 
     // Parse ProcessData response
     void parseProcessData(DBusMessage* reply, const std::function<void(const std::string&)>& callback) {
-        DBusError error;
-        dbus_error_init(&error);
-
         const char* result;
-        if ( false == dbus_message_get_args(
-            reply,
-            &error,
-            DBUS_TYPE_STRING,
-            &result,
-            DBUS_TYPE_INVALID)
-            ) {
-            std::cerr << error.name << std::endl << error.message << std::endl;
-            dbus_error_free(&error);
+        if ( false == CalculatorClient::checkParsed<const char*>(reply, DBusArgs<const char*>::read(reply, result)) ) {
             return;
         }
 
         if (callback) {
             callback(std::string(result));
         }
-        dbus_error_free(&error);
     }
 };
 
@@ -251,10 +455,13 @@ int main() {
     }
 
     // DBus connection (SYSTEM by default; set DBUS_BUS_TYPE=session to override)
-    DBusConn dbus_conn(bus_type);
+    // Direct mode: set DBUS_PEER_ADDRESS to the address calculator_service listens on
+    const char* peer_address = std::getenv("DBUS_PEER_ADDRESS");
+    std::unique_ptr<DBusConn> dbus_conn(
+        (peer_address && *peer_address) ? new DBusConn(peer_address) : new DBusConn(bus_type));
 
     // Client
-    CalculatorClient client(dbus_conn.getConn());
+    CalculatorClient client(dbus_conn->getConn());
 
     std::cout << "=== Calculator Service Client ===" << std::endl << std::endl;
 
@@ -288,5 +495,158 @@ int main() {
         std::cout << "Result: " << result << std::endl;
     });
 
+    std::cout << std::endl;
+
+    // Pipelined Add(i, i) calls, all in flight on one connection
+    const int pipelined = 100;
+    std::cout << "Calling Add(i, i) x " << pipelined << " (pipelined)..." << std::endl;
+    long long sum = 0;
+    std::vector<std::future<bool>> results;
+    results.reserve(pipelined);
+    for (int i = 0; i < pipelined; ++i) {
+        results.push_back(client.callAddAsync(i, i, [&sum](int result) {
+            sum += result;
+        }));
+    }
+    client.waitPending();
+    int failed = 0;
+    for (auto& result : results) {
+        failed += (false == result.get()) ? 1 : 0;
+    }
+    std::cout << "Result: sum=" << sum << ", failed=" << failed << std::endl;
+
+    std::cout << std::endl;
+
+    // Batch: the same kind of job as one unit with one overall timeout
+    const int batched = 1000;
+    std::vector<std::pair<int32_t, int32_t>> operands;
+    operands.reserve(batched);
+    for (int i = 0; i < batched; ++i) {
+        operands.emplace_back(i, i);
+    }
+    std::cout << "Calling Add(i, i) x " << batched << " (one batch)..." << std::endl;
+    long long batch_sum = 0;
+    const auto batch_begin = std::chrono::steady_clock::now();
+    const size_t batch_failed = client.callAddBatch(operands, 5000, [&batch_sum](size_t /*index*/, int result) {
+        batch_sum += result;
+    });
+    const auto batch_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - batch_begin).count();
+    // Same calls, one blocking round trip each
+    const auto serial_begin = std::chrono::steady_clock::now();
+    for (const auto& pair : operands) {
+        client.callAdd(pair.first, pair.second);
+    }
+    const auto serial_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - serial_begin).count();
+    std::cout << "Result: sum=" << batch_sum << ", failed=" << batch_failed
+              << ", " << batch_elapsed << " us (one by one: " << serial_elapsed << " us)" << std::endl;
+
+    std::cout << std::endl;
+
+    // Array methods: whole vectors per call
+    std::cout << "Calling AddArrays([1, 2, 3, 4], [10, 20, 30, 40])..." << std::endl;
+    client.callAddArrays({ 1, 2, 3, 4 }, { 10, 20, 30, 40 }, [](const DBusFixedArray<int32_t>& result) {
+        std::cout << "Result:";
+        for (int32_t value : result) {
+            std::cout << " " << value;
+        }
+        std::cout << std::endl;
+    });
+
+    std::cout << std::endl;
+
+    std::cout << "Calling MultiplyArrays([1.5, 2.5], [2, 4])..." << std::endl;
+    client.callMultiplyArrays({ 1.5, 2.5 }, { 2.0, 4.0 }, [](const DBusFixedArray<double>& result) {
+        std::cout << "Result:";
+        for (double value : result) {
+            std::cout << " " << value;
+        }
+        std::cout << std::endl;
+    });
+
+    std::cout << std::endl;
+
+    // One call, one million multiply-adds
+    const size_t elements = 1000000;
+    std::vector<double> ones(elements, 1.0);
+    std::vector<double> ramp(elements);
+    for (size_t i = 0; i < elements; ++i) {
+        ramp[i] = static_cast<double>(i);
+    }
+    std::cout << "Calling Dot(1.0 x " << elements << ", 0.." << (elements - 1) << ")..." << std::endl;
+    const auto begin = std::chrono::steady_clock::now();
+    client.callDot(ones, ramp, [](double result) {
+        std::cout << "Result: " << static_cast<long long>(result) << std::endl;
+    });
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "Round trip: " << elapsed << " us" << std::endl;
+
+    std::cout << std::endl;
+
+    std::cout << "Calling Sum(0.." << (elements - 1) << ")..." << std::endl;
+    client.callSum(ramp, [](double result) {
+        std::cout << "Result: " << static_cast<long long>(result) << std::endl;
+    });
+
+    std::cout << std::endl;
+
+    // Bulk data by memfd: 32 MiB of doubles, only the fd crosses the socket
+    const size_t bulk = 4 * 1024 * 1024;
+    MemfdBuffer input;
+    if (input.create("calc-input", bulk)) {
+        for (size_t i = 0; i < bulk; ++i) {
+            input.values()[i] = static_cast<double>(i);
+        }
+        if (input.seal()) {
+            std::cout << "Calling SumFd(memfd 0.." << (bulk - 1) << ")..." << std::endl;
+            const auto fd_begin = std::chrono::steady_clock::now();
+            client.callSumFd(input, [](double result) {
+                std::cout << "Result: " << static_cast<long long>(result) << std::endl;
+            });
+            const auto fd_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - fd_begin).count();
+            std::cout << "Round trip: " << fd_elapsed << " us" << std::endl;
+
+            std::cout << std::endl;
+
+            std::cout << "Calling ScaleFd(memfd 0.." << (bulk - 1) << ", 0.5)..." << std::endl;
+            client.callScaleFd(input, 0.5, [](const MemfdBuffer& output) {
+                std::cout << "Result: " << output.size() << " values, last=" << output.values()[output.size() - 1] << std::endl;
+            });
+        }
+    }
+
+    std::cout << std::endl;
+
+    // Thread-safe mode: several threads share the client (and its connection)
+    {
+        DBusDispatcher dispatcher(dbus_conn->getConn());
+        client.setDispatcher(&dispatcher);
+
+        const int threads = 4;
+        const int calls_per_thread = 250;
+        std::cout << "Calling Add(i, 1) x " << (threads * calls_per_thread)
+                  << " from " << threads << " threads (shared client)..." << std::endl;
+        std::atomic<long long> shared_sum(0);
+        std::atomic<int> answered(0);
+        const auto shared_begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> callers;
+        for (int t = 0; t < threads; ++t) {
+            callers.emplace_back( [&client, &shared_sum, &answered, t, calls_per_thread] () {
+                for (int i = 0; i < calls_per_thread; ++i) {
+                    client.callAdd(t * calls_per_thread + i, 1, [&shared_sum, &answered](int result) {
+                        shared_sum += result;
+                        ++answered;
+                    });
+                }
+            } );
+        }
+        for (std::thread& caller : callers) {
+            caller.join();
+        }
+        const auto shared_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - shared_begin).count();
+        client.setDispatcher(nullptr);
+        std::cout << "Result: sum=" << shared_sum.load() << ", answered=" << answered.load()
+                  << ", " << shared_elapsed << " us" << std::endl;
+    }
+
     return 0;
 }
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CALC_KERNELS_X86 1
+#endif
+
+//
+// Array kernels
+//
+// Element-wise and reduction loops used by the calculator array methods.
+// On x86 each kernel has an AVX2 (+FMA) and an SSE2 version compiled with a
+// target attribute, so the binary still runs on any x86; the CPU is checked
+// once and the widest supported version is used (SSE2 is always there on
+// x86-64). Other architectures get the scalar loops. Integer adds wrap like
+// unsigned arithmetic. Reductions sum in several lanes, so the last bits of
+// a double result may differ from a strictly sequential sum.
+
+namespace CalculatorKernels {
+
+inline bool hasAvx2() {
+#if defined(CALC_KERNELS_X86)
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+inline bool hasSse2() {
+#if defined(__x86_64__)
+    return true;
+#elif defined(CALC_KERNELS_X86)
+    static const bool supported = __builtin_cpu_supports("sse2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+//
+// Scalar
+//
+
+inline void addInt32Scalar(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<int32_t>(static_cast<uint32_t>(a[i]) + static_cast<uint32_t>(b[i]));
+    }
+}
+
+inline void multiplyDoubleScalar(const double* a, const double* b, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+inline void scaleDoubleScalar(const double* a, double factor, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * factor;
+    }
+}
+
+inline double dotScalar(const double* a, const double* b, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+inline double sumScalar(const double* a, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i];
+    }
+    return sum;
+}
+
+//
+// SSE2 (unaligned loads: arrays point straight into the message buffer)
+//
+
+#if defined(CALC_KERNELS_X86)
+__attribute__((target("sse2")))
+inline void addInt32Sse2(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi32(va, vb));
+    }
+    addInt32Scalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("sse2")))
+inline void multiplyDoubleSse2(const double* a, const double* b, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    multiplyDoubleScalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("sse2")))
+inline void scaleDoubleSse2(const double* a, double factor, double* out, size_t n) {
+    const __m128d vf = _mm_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), vf));
+    }
+    scaleDoubleScalar(a + i, factor, out + i, n - i);
+}
+
+// Horizontal add of two lanes
+__attribute__((target("sse2")))
+inline double reduceSse2(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+__attribute__((target("sse2")))
+inline double dotSse2(const double* a, const double* b, size_t n) {
+    // Four independent accumulators hide the add latency
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd();
+    __m128d acc3 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i),     _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(a + i + 4), _mm_loadu_pd(b + i + 4)));
+        acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(a + i + 6), _mm_loadu_pd(b + i + 6)));
+    }
+    for (; i + 2 <= n; i += 2) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    const __m128d acc = _mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3));
+    return reduceSse2(acc) + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2")))
+inline double sumSse2(const double* a, size_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd();
+    __m128d acc3 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(a + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(a + i + 2));
+        acc2 = _mm_add_pd(acc2, _mm_loadu_pd(a + i + 4));
+        acc3 = _mm_add_pd(acc3, _mm_loadu_pd(a + i + 6));
+    }
+    for (; i + 2 <= n; i += 2) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(a + i));
+    }
+    const __m128d acc = _mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3));
+    return reduceSse2(acc) + sumScalar(a + i, n - i);
+}
+#endif
+
+//
+// AVX2 (unaligned loads: arrays point straight into the message buffer)
+//
+
+#if defined(CALC_KERNELS_X86)
+__attribute__((target("avx2")))
+inline void addInt32Avx2(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi32(va, vb));
+    }
+    addInt32Scalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void multiplyDoubleAvx2(const double* a, const double* b, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    multiplyDoubleScalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void scaleDoubleAvx2(const double* a, double factor, double* out, size_t n) {
+    const __m256d vf = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), vf));
+    }
+    scaleDoubleScalar(a + i, factor, out + i, n - i);
+}
+
+// Horizontal add of four lanes
+__attribute__((target("avx2")))
+inline double reduceAvx2(__m256d v) {
+    const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+__attribute__((target("avx2,fma")))
+inline double dotAvx2(const double* a, const double* b, size_t n) {
+    // Four independent accumulators hide the FMA latency
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i),      _mm256_loadu_pd(b + i),      acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4),  _mm256_loadu_pd(b + i + 4),  acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8),  _mm256_loadu_pd(b + i + 8),  acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), acc3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+    }
+    const __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    return reduceAvx2(acc) + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline double sumAvx2(const double* a, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(a + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(a + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+    }
+    const __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    return reduceAvx2(acc) + sumScalar(a + i, n - i);
+}
+#endif
+
+//
+// Dispatch
+//
+
+inline void addInt32(const int32_t* a, const int32_t* b, int32_t* out, size_t n) {
+#if defined(CALC_KERNELS_X86)
+    if (hasAvx2()) {
+        addInt32Avx2(a, b, out, n);
+        return;
+    }
+    if (hasSse2()) {
+        addInt32Sse2(a, b, out, n);
+        return;
+    }
+#endif
+    addInt32Scalar(a, b, out, n);
+}
+
+inline void multiplyDouble(const double* a, const double* b, double* out, size_t n) {
+#if defined(CALC_KERNELS_X86)
+    if (hasAvx2()) {
+        multiplyDoubleAvx2(a, b, out, n);
+        return;
+    }
+    if (hasSse2()) {
+        multiplyDoubleSse2(a, b, out, n);
+        return;
+    }
+#endif
+    multiplyDoubleScalar(a, b, out, n);
+}
+
+inline void scaleDouble(const double* a, double factor, double* out, size_t n) {
+#if defined(CALC_KERNELS_X86)
+    if (hasAvx2()) {
+        scaleDoubleAvx2(a, factor, out, n);
+        return;
+    }
+    if (hasSse2()) {
+        scaleDoubleSse2(a, factor, out, n);
+        return;
+    }
+#endif
+    scaleDoubleScalar(a, factor, out, n);
+}
+
+inline double dot(const double* a, const double* b, size_t n) {
+#if defined(CALC_KERNELS_X86)
+    if (hasAvx2()) {
+        return dotAvx2(a, b, n);
+    }
+    if (hasSse2()) {
+        return dotSse2(a, b, n);
+    }
+#endif
+    return dotScalar(a, b, n);
+}
+
+inline double sum(const double* a, size_t n) {
+#if defined(CALC_KERNELS_X86)
+    if (hasAvx2()) {
+        return sumAvx2(a, n);
+    }
+    if (hasSse2()) {
+        return sumSse2(a, n);
+    }
+#endif
+    return sumScalar(a, n);
+}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// Memfd buffer
+//
+// Array of doubles in an anonymous memory file, shared between processes
+// by passing the fd (D-Bus type 'h'). The data itself never goes through
+// the socket: each side maps the same pages.
+//
+// A receiver only maps buffers sealed against writes and shrinking, so the
+// sender can neither change the data under it nor truncate the file and
+// crash it with SIGBUS. The writer side creates, fills, then seal()s.
+
+class MemfdBuffer {
+public:
+    // Required on every buffer we read
+    static constexpr int kReadSeals = F_SEAL_WRITE | F_SEAL_SHRINK;
+    // Applied to every buffer we hand out
+    static constexpr int kAllSeals = F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+private:
+    int fd;
+    double* data;
+    size_t count;
+
+public:
+    // Constructor (empty; see create / open)
+    MemfdBuffer() : fd(-1), data(nullptr), count(0) {}
+    // delete
+    MemfdBuffer(MemfdBuffer&& other) = delete;
+    MemfdBuffer& operator=(MemfdBuffer&& other) = delete;
+    MemfdBuffer(const MemfdBuffer&) = delete;
+    MemfdBuffer& operator=(const MemfdBuffer&) = delete;
+    // De-Constructor
+    ~MemfdBuffer() {
+        this->MemfdBuffer::unmap();
+        if (this->fd >= 0) {
+            close(this->fd);
+        }
+    }
+
+public:
+    // New writable buffer of count doubles
+    bool create(const char* name, size_t element_count) {
+        this->fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (this->fd < 0) {
+            std::cerr << "Memfd Error: memfd_create: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (0 != ftruncate(this->fd, static_cast<off_t>(element_count * sizeof(double)))) {
+            std::cerr << "Memfd Error: ftruncate: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        this->count = element_count;
+        return this->MemfdBuffer::map(PROT_READ | PROT_WRITE);
+    }
+
+    // Map a received buffer read-only (takes ownership of the fd)
+    bool open(int received_fd) {
+        this->fd = received_fd;
+
+        const int seals = fcntl(this->fd, F_GET_SEALS);
+        if (seals < 0 || (seals & kReadSeals) != kReadSeals) {
+            std::cerr << "Memfd Error: buffer is not sealed against write / shrink" << std::endl;
+            return false;
+        }
+
+        struct stat info;
+        if (0 != fstat(this->fd, &info) || 0 != (info.st_size % sizeof(double))) {
+            std::cerr << "Memfd Error: size is not a whole number of doubles" << std::endl;
+            return false;
+        }
+        this->count = static_cast<size_t>(info.st_size) / sizeof(double);
+        return this->MemfdBuffer::map(PROT_READ);
+    }
+
+    // Drop the writable mapping and seal (required before F_SEAL_WRITE)
+    bool seal() {
+        this->MemfdBuffer::unmap();
+        if (0 != fcntl(this->fd, F_ADD_SEALS, kAllSeals)) {
+            std::cerr << "Memfd Error: F_ADD_SEALS: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Re-map a sealed buffer read-only (e.g. to read back what was sent)
+    bool mapReadOnly() {
+        return nullptr != this->data || this->MemfdBuffer::map(PROT_READ);
+    }
+
+    double* values() { return this->data; }
+    const double* values() const { return this->data; }
+    size_t size() const { return this->count; }
+    int getFd() const { return this->fd; }
+
+private:
+    bool map(int protection) {
+        // mmap rejects a zero length; an empty buffer needs no mapping
+        if (0 == this->count) {
+            return true;
+        }
+        void* addr = mmap(nullptr, this->count * sizeof(double), protection, MAP_SHARED, this->fd, 0);
+        if (MAP_FAILED == addr) {
+            std::cerr << "Memfd Error: mmap: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        this->data = static_cast<double*>(addr);
+        return true;
+    }
+
+    void unmap() {
+        if (this->data) {
+            munmap(this->data, this->count * sizeof(double));
+            this->data = nullptr;
+        }
+    }
+};
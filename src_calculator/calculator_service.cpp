@@ -1,20 +1,57 @@
 #include <iostream>
 #include <thread>
 #include <future>
+#include <charconv>
 #include <cstdlib>
 #include <cstring>
+#include <memory_resource>
+#include <vector>
 
 #include "../include/dbus_conn_wrapper.hpp"
 #include "../include/dbus_server_wrapper.hpp"
+#include "../include/dbus_router.hpp"
+#include "../include/dbus_args.hpp"
+#include "../include/dbus_peer_wrapper.hpp"
+#include "calculator_kernels.hpp"
+#include "calculator_memfd.hpp"
 
 //
 // Controller
 //
 
-class CalculatorController : public IRouter {
+class CalculatorController : public DBusRouter {
 public:
     // Constructor
-    CalculatorController() {}
+    // (all four methods are pure: same arguments, same reply)
+    CalculatorController() {
+        // Add(int a, int b) -> int result
+        this->addPureMethod("com.example.CalcInterface", "Add", CalculatorController::prepareReplyAdd);
+        // Multiply(double a, double b) -> double result
+        this->addPureMethod("com.example.CalcInterface", "Multiply", CalculatorController::prepareReplyMultiply);
+        // Concatenate(string s1, string s2) -> string result
+        this->addPureMethod("com.example.CalcInterface", "Concatenate", CalculatorController::prepareReplyConcatenate);
+        // ProcessData(string name, int age, double salary) -> string message
+        this->addPureMethod("com.example.CalcInterface", "ProcessData", CalculatorController::prepareReplyProcessData);
+
+        // Array methods: one call carries whole vectors, arguments are read in
+        // place and computed with SIMD kernels. Not memoized: building a cache
+        // key would walk every element, costing more than the kernel itself.
+        // AddArrays(ai a, ai b) -> ai
+        this->addMethod("com.example.CalcInterface", "AddArrays", CalculatorController::prepareReplyAddArrays);
+        // MultiplyArrays(ad a, ad b) -> ad
+        this->addMethod("com.example.CalcInterface", "MultiplyArrays", CalculatorController::prepareReplyMultiplyArrays);
+        // Dot(ad a, ad b) -> d
+        this->addMethod("com.example.CalcInterface", "Dot", CalculatorController::prepareReplyDot);
+        // Sum(ad a) -> d
+        this->addMethod("com.example.CalcInterface", "Sum", CalculatorController::prepareReplySum);
+
+        // Bulk data by file descriptor: sealed memfds of doubles, mapped on
+        // both sides, so no payload byte goes through the socket
+        // SumFd(h input) -> d
+        this->addMethod("com.example.CalcInterface", "SumFd", CalculatorController::prepareReplySumFd);
+        // ScaleFd(h input, d factor) -> h output
+        this->addMethod("com.example.CalcInterface", "ScaleFd", CalculatorController::prepareReplyScaleFd);
+    }
     // delete
     CalculatorController(CalculatorController&& other) = delete;
     CalculatorController& operator=(CalculatorController&& other) = delete;
@@ -23,140 +60,214 @@ public:
     // De-Constructor
     ~CalculatorController() {}
 
-public:
-    DBusMessage* handleRequest(DBusMessage* message) override {
-        // Add(int a, int b) -> int result
-        if ( true == dbus_message_is_method_call(message, "com.example.CalcInterface", "Add") ) {
-            return CalculatorController::prepareReplyAdd(message);
-        }
-        // Multiply(double a, double b) -> double result
-        else if ( true == dbus_message_is_method_call(message, "com.example.CalcInterface", "Multiply") ) {
-            return CalculatorController::prepareReplyMultiply(message);
-        }
-        // Concatenate(string s1, string s2) -> string result
-        else if ( true == dbus_message_is_method_call(message, "com.example.CalcInterface", "Concatenate") ) {
-            return CalculatorController::prepareReplyConcatenate(message);
-        }
-        // ProcessData(string name, int age, double salary) -> string message
-        else if ( true == dbus_message_is_method_call(message, "com.example.CalcInterface", "ProcessData") ) {
-            return CalculatorController::prepareReplyProcessData(message);
-        }
-        else {
-            return dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_METHOD, "Method not found");
-        }
-    }
-
 private:
     // Add(int a, int b) -> int
     static DBusMessage* prepareReplyAdd(DBusMessage* message) {
-        int a, b;
-        if ( false == dbus_message_get_args(
-            message,
-            nullptr,
-            DBUS_TYPE_INT32,
-            &a,
-            DBUS_TYPE_INT32,
-            &b,
-            DBUS_TYPE_INVALID)
-            ) {
+        int32_t a, b;
+        if ( false == DBusArgs<int32_t, int32_t>::read(message, a, b) ) {
             return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected two int32 arguments");
         }
 
-        int result = a + b;
+        int32_t result = a + b;
         DBusMessage* reply = dbus_message_new_method_return(message);
-        dbus_message_append_args(
-            reply,
-            DBUS_TYPE_INT32,
-            &result,
-            DBUS_TYPE_INVALID);
-        
+        DBusArgs<int32_t>::append(reply, result);
+
         return reply;
     }
 
     // Multiply(double a, double b) -> double
     static DBusMessage* prepareReplyMultiply(DBusMessage* message) {
         double a, b;
-        if ( false == dbus_message_get_args(
-            message,
-            nullptr,
-            DBUS_TYPE_DOUBLE,
-            &a,
-            DBUS_TYPE_DOUBLE,
-            &b,
-            DBUS_TYPE_INVALID)
-            ) {
+        if ( false == DBusArgs<double, double>::read(message, a, b) ) {
             return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected two double arguments");
         }
 
         double result = a * b;
         DBusMessage* reply = dbus_message_new_method_return(message);
-        dbus_message_append_args(
-            reply,
-            DBUS_TYPE_DOUBLE,
-            &result,
-            DBUS_TYPE_INVALID);
-        
+        DBusArgs<double>::append(reply, result);
+
         return reply;
     }
 
     // Concatenate(string s1, string s2) -> string
-    static DBusMessage* prepareReplyConcatenate(DBusMessage* message) {
-        const char* s1;
-        const char* s2;
-        if ( false == dbus_message_get_args(
-            message,
-            nullptr,
-            DBUS_TYPE_STRING,
-            &s1,
-            DBUS_TYPE_STRING,
-            &s2,
-            DBUS_TYPE_INVALID)
-            ) {
+    // (result is built in the request arena)
+    static DBusMessage* prepareReplyConcatenate(DBusMessage* message, std::pmr::memory_resource* arena) {
+        std::string_view s1, s2;
+        if ( false == DBusArgs<std::string_view, std::string_view>::read(message, s1, s2) ) {
             return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected two string arguments");
         }
 
-        std::string result = std::string(s1) + " + " + std::string(s2);
-        const char* result_cstr = result.c_str();
+        std::pmr::string result(arena);
+        result.reserve(s1.size() + 3 + s2.size());
+        result.append(s1).append(" + ").append(s2);
         DBusMessage* reply = dbus_message_new_method_return(message);
-        dbus_message_append_args(
-            reply,
-            DBUS_TYPE_STRING,
-            &result_cstr,
-            DBUS_TYPE_INVALID);
-        
+        DBusArgs<std::pmr::string>::append(reply, result);
+
         return reply;
     }
 
     // ProcessData(string name, int age, double salary) -> string
-    static DBusMessage* prepareReplyProcessData(DBusMessage* message) {
-        const char* name;
-        int age;
+    // (result is built in the request arena; numbers go through to_chars)
+    static DBusMessage* prepareReplyProcessData(DBusMessage* message, std::pmr::memory_resource* arena) {
+        std::string_view name;
+        int32_t age;
         double salary;
-        if ( false == dbus_message_get_args(
-            message,
-            nullptr,
-            DBUS_TYPE_STRING,
-            &name,
-            DBUS_TYPE_INT32,
-            &age,
-            DBUS_TYPE_DOUBLE,
-            &salary,
-            DBUS_TYPE_INVALID)
-            ) {
+        if ( false == DBusArgs<std::string_view, int32_t, double>::read(message, name, age, salary) ) {
             return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected string, int32, and double arguments");
         }
 
-        std::string msg = std::string("Employee: ") + name + 
-                         ", Age: " + std::to_string(age) + 
-                         ", Salary: $" + std::to_string(salary);
-        const char* msg_cstr = msg.c_str();
+        // Same text as std::to_string: decimal age, salary with 6 decimals
+        // (fixed notation of DBL_MAX needs 316 characters)
+        char age_text[16];
+        char salary_text[320];
+        const auto age_end = std::to_chars(age_text, age_text + sizeof(age_text), age);
+        const auto salary_end = std::to_chars(salary_text, salary_text + sizeof(salary_text), salary, std::chars_format::fixed, 6);
+        if (std::errc() != age_end.ec || std::errc() != salary_end.ec) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Unable to format arguments");
+        }
+
+        std::pmr::string msg(arena);
+        msg.reserve(64 + name.size());
+        msg.append("Employee: ").append(name)
+           .append(", Age: ").append(age_text, age_end.ptr)
+           .append(", Salary: $").append(salary_text, salary_end.ptr);
         DBusMessage* reply = dbus_message_new_method_return(message);
-        dbus_message_append_args(
-            reply,
-            DBUS_TYPE_STRING,
-            &msg_cstr,
-            DBUS_TYPE_INVALID);
-        
+        DBusArgs<std::pmr::string>::append(reply, msg);
+
+        return reply;
+    }
+
+    // AddArrays(ai a, ai b) -> ai (element-wise, wrapping)
+    static DBusMessage* prepareReplyAddArrays(DBusMessage* message, std::pmr::memory_resource* arena) {
+        DBusFixedArray<int32_t> a, b;
+        if ( false == DBusArgs<DBusFixedArray<int32_t>, DBusFixedArray<int32_t>>::read(message, a, b) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected two int32 arrays");
+        }
+        if (a.size != b.size) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Arrays must have the same length");
+        }
+
+        // Small results stay in the request arena, large ones spill to the heap
+        std::pmr::vector<int32_t> result(a.size, arena);
+        CalculatorKernels::addInt32(a.data, b.data, result.data(), a.size);
+
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        if ( nullptr == reply
+            || false == DBusArgs<DBusFixedArray<int32_t>>::append(reply, DBusFixedArray<int32_t>{ result.data(), result.size() }) ) {
+            if (reply) {
+                dbus_message_unref(reply);
+            }
+            return dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "Unable to build reply");
+        }
+        return reply;
+    }
+
+    // MultiplyArrays(ad a, ad b) -> ad (element-wise)
+    static DBusMessage* prepareReplyMultiplyArrays(DBusMessage* message, std::pmr::memory_resource* arena) {
+        DBusFixedArray<double> a, b;
+        if ( false == DBusArgs<DBusFixedArray<double>, DBusFixedArray<double>>::read(message, a, b) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected two double arrays");
+        }
+        if (a.size != b.size) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Arrays must have the same length");
+        }
+
+        std::pmr::vector<double> result(a.size, arena);
+        CalculatorKernels::multiplyDouble(a.data, b.data, result.data(), a.size);
+
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        if ( nullptr == reply
+            || false == DBusArgs<DBusFixedArray<double>>::append(reply, DBusFixedArray<double>{ result.data(), result.size() }) ) {
+            if (reply) {
+                dbus_message_unref(reply);
+            }
+            return dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "Unable to build reply");
+        }
+        return reply;
+    }
+
+    // Dot(ad a, ad b) -> d
+    static DBusMessage* prepareReplyDot(DBusMessage* message) {
+        DBusFixedArray<double> a, b;
+        if ( false == DBusArgs<DBusFixedArray<double>, DBusFixedArray<double>>::read(message, a, b) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected two double arrays");
+        }
+        if (a.size != b.size) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Arrays must have the same length");
+        }
+
+        double result = CalculatorKernels::dot(a.data, b.data, a.size);
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        DBusArgs<double>::append(reply, result);
+
+        return reply;
+    }
+
+    // Sum(ad a) -> d
+    static DBusMessage* prepareReplySum(DBusMessage* message) {
+        DBusFixedArray<double> a;
+        if ( false == DBusArgs<DBusFixedArray<double>>::read(message, a) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected one double array");
+        }
+
+        double result = CalculatorKernels::sum(a.data, a.size);
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        DBusArgs<double>::append(reply, result);
+
+        return reply;
+    }
+
+    // SumFd(h input) -> d
+    static DBusMessage* prepareReplySumFd(DBusMessage* message) {
+        DBusUnixFd input_fd;
+        if ( false == DBusArgs<DBusUnixFd>::read(message, input_fd) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected one file descriptor");
+        }
+
+        MemfdBuffer input;
+        if ( false == input.open(input_fd.fd) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected a memfd of doubles sealed against write and shrink");
+        }
+
+        double result = CalculatorKernels::sum(input.values(), input.size());
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        DBusArgs<double>::append(reply, result);
+
+        return reply;
+    }
+
+    // ScaleFd(h input, d factor) -> h (new sealed memfd, input * factor)
+    static DBusMessage* prepareReplyScaleFd(DBusMessage* message) {
+        DBusUnixFd input_fd;
+        double factor;
+        if ( false == DBusArgs<DBusUnixFd, double>::read(message, input_fd, factor) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected a file descriptor and a double");
+        }
+
+        MemfdBuffer input;
+        if ( false == input.open(input_fd.fd) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Expected a memfd of doubles sealed against write and shrink");
+        }
+
+        // Written straight into the shared pages, then sealed for the caller
+        MemfdBuffer output;
+        if ( false == output.create("calc-scale", input.size()) ) {
+            return dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "Unable to create output buffer");
+        }
+        CalculatorKernels::scaleDouble(input.values(), factor, output.values(), input.size());
+        if ( false == output.seal() ) {
+            return dbus_message_new_error(message, DBUS_ERROR_FAILED, "Unable to seal output buffer");
+        }
+
+        // The reply holds its own duplicate; ours is closed with output
+        DBusMessage* reply = dbus_message_new_method_return(message);
+        if ( nullptr == reply
+            || false == DBusArgs<DBusUnixFd>::append(reply, DBusUnixFd{ output.getFd() }) ) {
+            if (reply) {
+                dbus_message_unref(reply);
+            }
+            return dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "Unable to build reply");
+        }
         return reply;
     }
 };
@@ -185,26 +296,8 @@ public:
             return;
         }
 
-        // Main loop
-        for (;;) {
-            // Wait for client connection
-            dbus_connection_read_write_dispatch(this->conn, -1);
-
-            // Get message
-            DBusMessage* message = nullptr;
-            if ( nullptr == (message = dbus_connection_pop_message(this->conn)) ) {
-                std::cout << this->error.name << std::endl << this->error.message << std::endl;
-                continue;
-            }
-
-            // Run session
-            this->DBusServer::runSession(message);
-
-            // Release Message
-            if (message) {
-                dbus_message_unref(message);
-            }
-        }
+        // Main loop (drain mode: up to max batch per wakeup, one flush per batch)
+        this->DBusServer::run();
     }
 };
 
@@ -213,12 +306,39 @@ public:
 //
 
 int main() {
-    // DBus connection (type: DBUS_BUS_SYSTEM / DBUS_BUS_SESSION)
-    DBusConn dbus_conn(DBUS_BUS_SYSTEM);
-
     // Controller
     CalculatorController calc_ctl;
 
+    // Memoize replies (e.g. CALC_REPLY_CACHE=1024 entries)
+    const char* cache_entries = std::getenv("CALC_REPLY_CACHE");
+    if (cache_entries && std::atoi(cache_entries) > 0) {
+        calc_ctl.enableReplyCache(static_cast<size_t>(std::atoi(cache_entries)));
+    }
+
+    // Direct mode: listen on a private socket, no bus daemon
+    // (e.g. DBUS_PEER_ADDRESS=unix:path=/tmp/calc.sock)
+    const char* peer_address = std::getenv("DBUS_PEER_ADDRESS");
+    if (peer_address && *peer_address) {
+        DBusEventLoop loop;
+        DBusPeerServer peer_server(peer_address, &calc_ctl, loop);
+        if (false == peer_server.isListening()) {
+            return 1;
+        }
+        std::cout << "Listening on " << peer_server.getAddress() << std::endl;
+        loop.run();
+        return 0;
+    }
+
+    // Bus type
+    DBusBusType bus_type = DBUS_BUS_SYSTEM;
+    const char* env_bus_type = std::getenv("DBUS_BUS_TYPE");
+    if (env_bus_type && std::strcmp(env_bus_type, "session") == 0) {
+        bus_type = DBUS_BUS_SESSION;
+    }
+
+    // DBus connection (SYSTEM by default; set DBUS_BUS_TYPE=session to override)
+    DBusConn dbus_conn(bus_type);
+
     // Service (BlockAcceptService only)
     BlockAcceptService service(dbus_conn.getConn(), &calc_ctl);
     service.run();
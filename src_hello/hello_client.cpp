@@ -1,8 +1,10 @@
 #include <iostream>
 #include <functional>
+#include <vector>
 
 #include "../include/dbus_conn_wrapper.hpp"
 #include "../include/dbus_client_wrapper.hpp"
+#include "../include/dbus_args.hpp"
 
 class HelloClient : public DBusClient {
 private:
@@ -45,13 +47,8 @@ public:
             this->interface_name,
             "Hello",
             [&who] (DBusMessage* method_call) {
-                if ( false == dbus_message_append_args(
-                    method_call,
-                    DBUS_TYPE_STRING,
-                    &who,
-                    DBUS_TYPE_INVALID)
-                    ) {
-                    std::cerr << "ERROR: dbus_message_append_args - Unable to append argument!" << std::endl;
+                if ( false == DBusArgs<const char*>::append(method_call, who) ) {
+                    std::cerr << "ERROR: Unable to append argument!" << std::endl;
                     return false;
                 }
                 return true;
@@ -62,32 +59,42 @@ public:
         );
     }
 
+    // Non-blocking version (call waitPending() or future.get() after pumping)
+    std::future<bool> callHelloAsync(const char* who, const std::function<void(const std::string&)>& callback = nullptr) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->interface_name,
+            "Hello",
+            [&who] (DBusMessage* method_call) {
+                if ( false == DBusArgs<const char*>::append(method_call, who) ) {
+                    std::cerr << "ERROR: Unable to append argument!" << std::endl;
+                    return false;
+                }
+                return true;
+            },
+            [this, callback] (DBusMessage* reply) {
+                this->HelloClient::parseHello(reply, callback);
+            }
+        );
+    }
+
 private:
     // s
     void parseHello(DBusMessage* reply, const std::function<void(const std::string&)>& callback) {
-        DBusError error;
-        dbus_error_init(&error);
-
         // response
         const char* response;
 
         // Parse reply
-        if ( false == dbus_message_get_args(
-            reply,
-            &error,
-            DBUS_TYPE_STRING,
-            &response,
-            DBUS_TYPE_INVALID)
-            ) {
-            std::cout << error.name << std::endl << error.message << std::endl;
+        if ( false == DBusArgs<const char*>::read(reply, response) ) {
+            std::cout << "Unexpected reply signature: " << dbus_message_get_signature(reply) << std::endl;
+            return;
         }
 
         // Execute callback
         if (callback) {
             callback(response);
         }
-
-        dbus_error_free(&error);
     }
 };
 
@@ -105,6 +112,17 @@ int main() {
             std::cout << response << std::endl;
         }
     );
+    // pipelined calls (all in flight on one connection)
+    std::vector<std::future<bool>> results;
+    for (const char* who : { "Alice", "Bob", "Carol" }) {
+        results.push_back(client.callHelloAsync(who, HelloClient::showHello));
+    }
+    client.waitPending();
+    for (auto& result : results) {
+        if (false == result.get()) {
+            std::cerr << "ERROR: async Hello failed" << std::endl;
+        }
+    }
 
     return 0;
 }
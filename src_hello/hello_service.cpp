@@ -1,19 +1,28 @@
 #include <iostream>
 #include <thread>
 #include <future>       // for std::async
+#include <memory_resource>
+#include <string_view>
 //#include <memory>       // for smart pointer
 
 #include "../include/dbus_conn_wrapper.hpp"
 #include "../include/dbus_server_wrapper.hpp"
+#include "../include/dbus_router.hpp"
+#include "../include/dbus_args.hpp"
 
 //
 // Controller
 //
 
-class HelloController : public IRouter {
+class HelloController : public DBusRouter {
 public:
     // Constructor
-    HelloController() {}
+    HelloController() {
+        this->addMethod("com.example.HelloInterface", "Hello",
+            [] (DBusMessage* message, std::pmr::memory_resource* arena) {
+                return HelloController::prepareReply(message, arena, HelloController::Hello);
+            });
+    }
     // delete
     HelloController(HelloController&& other) = delete;
     HelloController& operator=(HelloController&& other) = delete;
@@ -22,50 +31,35 @@ public:
     // De-Constructor
     ~HelloController() {}
 
-public:
-    DBusMessage* handleRequest(DBusMessage* message) override {
-        if ( true == dbus_message_is_method_call(message, "com.example.HelloInterface", "Hello") ) {
-            return HelloController::prepareReply(message, HelloController::Hello);
-        }
-        else {
-            return dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_METHOD, "Method not found");
-        }
-    }
-
 private:
-    static DBusMessage* prepareReply(DBusMessage* message, std::function<std::string(const std::string&)> method) {
-        // Get input from message (single input)
-        const char* input;
-        if ( false == dbus_message_get_args(
-            message,
-            nullptr,
-            DBUS_TYPE_STRING,
-            &input,
-            DBUS_TYPE_INVALID)
-            ) {
+    using Method = std::pmr::string (*)(std::string_view, std::pmr::memory_resource*);
+
+    static DBusMessage* prepareReply(DBusMessage* message, std::pmr::memory_resource* arena, Method method) {
+        // Get input from message (single input, view into the message)
+        std::string_view input;
+        if ( false == DBusArgs<std::string_view>::read(message, input) ) {
             return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Invalid argument format");
-        } 
-                       
-        // Call method
-        std::string output = method(input);
-        
+        }
+
+        // Call method (output lives in the request arena)
+        std::pmr::string output = method(input, arena);
+
         // Create a reply message from message
         DBusMessage* reply = dbus_message_new_method_return(message);
 
         // Append output to reply
-        dbus_message_append_args(
-            reply,
-            DBUS_TYPE_STRING,
-            &output,
-            DBUS_TYPE_INVALID);
-        
+        DBusArgs<std::pmr::string>::append(reply, output);
+
         // Return reply
         return reply;
     }
 
 private:
-    static std::string Hello(const std::string& name) {
-        return "Hello " + name + "!\n";
+    static std::pmr::string Hello(std::string_view name, std::pmr::memory_resource* arena) {
+        std::pmr::string greeting(arena);
+        greeting.reserve(name.size() + 8);
+        greeting.append("Hello ").append(name).append("!\n");
+        return greeting;
     }
 };
 
@@ -93,26 +87,8 @@ public:
             return;
         }
 
-        // Main loop
-        for (;;) {
-            // Wait for client connection
-            dbus_connection_read_write_dispatch(this->conn, -1);
-
-            // Get message
-            DBusMessage* message = nullptr;
-            if ( nullptr == (message = dbus_connection_pop_message(this->conn)) ) {
-                std::cout << this->error.name << std::endl << this->error.message << std::endl;
-                continue;
-            }
-
-            // Run session
-            this->DBusServer::runSession(message);
-
-            // Release Message
-            if (message) {
-                dbus_message_unref(message);
-            }
-        }
+        // Main loop (drain mode: up to max batch per wakeup, one flush per batch)
+        this->DBusServer::run();
     }
 };
 
@@ -143,25 +119,26 @@ public:
         // Main loop
         for (;;) {
             // Wait for client connection
-            dbus_connection_read_write_dispatch(this->conn, -1);
+            // (read only: dispatching would answer queued calls with UnknownMethod)
+            if ( false == dbus_connection_read_write(this->conn, -1) ) {
+                std::cout << "Connection closed" << std::endl;
+                return;
+            }
 
-            // Get message
+            // Get every queued message
             DBusMessage* message = nullptr;
-            if ( nullptr == (message = dbus_connection_pop_message(this->conn)) ) {
-                std::cout << this->error.name << std::endl << this->error.message << std::endl;
-                continue;
+            while ( nullptr != (message = dbus_connection_pop_message(this->conn)) ) {
+                std::async(std::launch::async,
+                    [this, message] () {
+                        // Run session
+                        this->DBusServer::runSession(message);
+
+                        // Release Message
+                        if (message) {
+                            dbus_message_unref(message);
+                        }
+                    } );
             }
-
-            std::async(std::launch::async,
-                [this, message] () {
-                    // Run session
-                    this->DBusServer::runSession(message);
-
-                    // Release Message
-                    if (message) {
-                        dbus_message_unref(message);
-                    }
-                } );
         }
     }
 };
@@ -194,27 +171,80 @@ public:
         // Main loop
         for (;;) {
             // Wait for client connection
-            dbus_connection_read_write_dispatch(this->conn, -1);
+            // (read only: dispatching would answer queued calls with UnknownMethod)
+            if ( false == dbus_connection_read_write(this->conn, -1) ) {
+                std::cout << "Connection closed" << std::endl;
+                return;
+            }
 
-            // Get message
+            // Get every queued message
             DBusMessage* message = nullptr;
-            if ( nullptr == (message = dbus_connection_pop_message(this->conn)) ) {
-                std::cout << this->error.name << std::endl << this->error.message << std::endl;
-                continue;
+            while ( nullptr != (message = dbus_connection_pop_message(this->conn)) ) {
+                std::thread( [this, message] ()
+                    {
+                        // Run session
+                        DBusServer::runSession(message);
+
+                        // Release Message
+                        if (message) {
+                            dbus_message_unref(message);
+                        }
+                    } ).detach();
+                    //} ).join();
             }
+        }
+    }
+};
+
+//
+// Worker Pool
+//
+// Fixed threads + bounded queue (no thread creation per request)
+
+class WorkerPoolService : public DBusServer {
+public:
+    // Constructor
+    WorkerPoolService(DBusConnection* dc, HelloController* ctl) : DBusServer(dc, "com.example.HelloService", ctl) {}
+    // delete
+    WorkerPoolService() = delete;
+    WorkerPoolService(WorkerPoolService&& other) = delete;
+    WorkerPoolService& operator=(WorkerPoolService&& other) = delete;
+    WorkerPoolService(const WorkerPoolService&) = delete;
+    WorkerPoolService& operator=(const WorkerPoolService&) = delete;
+    // De-Constructor
+    ~WorkerPoolService() {}
+
+    void run() override
+    {
+        this->DBusServer::runWorkerPool();
+    }
+};
 
-            std::thread( [this, message] ()
-                {
-                    // Run session
-                    DBusServer::runSession(message);
-
-                    // Release Message
-                    if (message) {
-                        dbus_message_unref(message);
-                    }
-                } ).detach();
-                //} ).join();
+//
+// Event Loop
+//
+// epoll-driven: one thread can serve this and other connections / timers
+
+class EventLoopService : public DBusServer {
+public:
+    // Constructor
+    EventLoopService(DBusConnection* dc, HelloController* ctl) : DBusServer(dc, "com.example.HelloService", ctl) {}
+    // delete
+    EventLoopService() = delete;
+    EventLoopService(EventLoopService&& other) = delete;
+    EventLoopService& operator=(EventLoopService&& other) = delete;
+    EventLoopService(const EventLoopService&) = delete;
+    EventLoopService& operator=(const EventLoopService&) = delete;
+    // De-Constructor
+    ~EventLoopService() {}
+
+    void run() override
+    {
+        DBusEventLoop loop;
+        if ( false == this->DBusServer::attach(loop) ) {
+            return;
         }
+        loop.run();
     }
 };
 
@@ -236,6 +266,10 @@ int main() {
     AsyncAcceptService service(dbus_conn.getConn(), &hello_ctl);
 #elif defined(THREAD_ACCEPT)
     ThreadAcceptService service(dbus_conn.getConn(), &hello_ctl);
+#elif defined(WORKER_POOL)
+    WorkerPoolService service(dbus_conn.getConn(), &hello_ctl);
+#elif defined(EVENT_LOOP)
+    EventLoopService service(dbus_conn.getConn(), &hello_ctl);
 #else
     BlockAcceptService service(dbus_conn.getConn(), &hello_ctl);
 #endif
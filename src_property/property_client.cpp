@@ -1,7 +1,20 @@
 #include <iostream>
 #include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
 #include "../include/dbus_conn_wrapper.hpp"
+#include "../include/dbus_call_batch.hpp"
 #include "../include/dbus_client_wrapper.hpp"
+#include "../include/dbus_args.hpp"
 
 //
 // Property Client
@@ -13,6 +26,16 @@ private:
     const char* object_path;
     const char* interface_name;
     const char* properties_interface;
+private:
+    // Opt-in cache (see enableCache())
+    using CachedValue = std::variant<int32_t, std::string>;
+    std::map<std::string, CachedValue, std::less<>> cache;
+    mutable std::shared_mutex cache_mutex;
+    // Own connection for PropertiesChanged, pumped by cache_thread, so the
+    // caller's connection never has a second thread blocked on its I/O path
+    DBusConnection* signal_conn;
+    std::thread cache_thread;
+    std::atomic<bool> cache_running;
 
 public:
     // Constructor
@@ -21,7 +44,9 @@ public:
         service_name("com.example.PropertyService"),
         object_path("/com/example/PropertyService"),
         interface_name("com.example.PropertyInterface"),
-        properties_interface("org.freedesktop.DBus.Properties")
+        properties_interface("org.freedesktop.DBus.Properties"),
+        signal_conn(nullptr),
+        cache_running(false)
     {}
     // delete
     PropertyClient() = delete;
@@ -30,7 +55,9 @@ public:
     PropertyClient(const PropertyClient&) = delete;
     PropertyClient& operator=(const PropertyClient&) = delete;
     // De-Constructor
-    ~PropertyClient() {}
+    ~PropertyClient() {
+        this->PropertyClient::disableCache();
+    }
 
 public:
     void getIntProperty(const char* property_name) {
@@ -40,33 +67,10 @@ public:
             this->properties_interface,
             "Get",
             [this, &property_name](DBusMessage* method_call) {
-                const char* interface = this->interface_name;
-                if (!dbus_message_append_args(
-                        method_call,
-                        DBUS_TYPE_STRING, &interface,
-                        DBUS_TYPE_STRING, &property_name,
-                        DBUS_TYPE_INVALID)) {
-                    std::cerr << "ERROR: Unable to append arguments!" << std::endl;
-                    return false;
-                }
-                return true;
+                return PropertyClient::appendGetArgs(method_call, this->interface_name, property_name);
             },
             [&property_name](DBusMessage* reply) {
-                DBusMessageIter iter, variant_iter;
-                int32_t value;
-
-                if (!dbus_message_iter_init(reply, &iter)) {
-                    std::cerr << "ERROR: Reply has no arguments!" << std::endl;
-                    return;
-                }
-
-                dbus_message_iter_recurse(&iter, &variant_iter);
-                if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_INT32) {
-                    dbus_message_iter_get_basic(&variant_iter, &value);
-                    std::cout << "[GET] " << property_name << " = " << value << std::endl;
-                } else {
-                    std::cerr << "ERROR: Unexpected property type!" << std::endl;
-                }
+                PropertyClient::parseIntReply(reply, property_name);
             });
     }
 
@@ -77,33 +81,10 @@ public:
             this->properties_interface,
             "Get",
             [this, &property_name](DBusMessage* method_call) {
-                const char* interface = this->interface_name;
-                if (!dbus_message_append_args(
-                        method_call,
-                        DBUS_TYPE_STRING, &interface,
-                        DBUS_TYPE_STRING, &property_name,
-                        DBUS_TYPE_INVALID)) {
-                    std::cerr << "ERROR: Unable to append arguments!" << std::endl;
-                    return false;
-                }
-                return true;
+                return PropertyClient::appendGetArgs(method_call, this->interface_name, property_name);
             },
             [&property_name](DBusMessage* reply) {
-                DBusMessageIter iter, variant_iter;
-                const char* value;
-
-                if (!dbus_message_iter_init(reply, &iter)) {
-                    std::cerr << "ERROR: Reply has no arguments!" << std::endl;
-                    return;
-                }
-
-                dbus_message_iter_recurse(&iter, &variant_iter);
-                if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_STRING) {
-                    dbus_message_iter_get_basic(&variant_iter, &value);
-                    std::cout << "[GET] " << property_name << " = " << value << std::endl;
-                } else {
-                    std::cerr << "ERROR: Unexpected property type!" << std::endl;
-                }
+                PropertyClient::parseStringReply(reply, property_name);
             });
     }
 
@@ -114,20 +95,9 @@ public:
             this->properties_interface,
             "Set",
             [this, &property_name, &value](DBusMessage* method_call) {
-                const char* interface = this->interface_name;
-                DBusMessageIter iter, variant_iter;
-
-                dbus_message_iter_init_append(method_call, &iter);
-                dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
-                dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &property_name);
-                
-                dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT, "i", &variant_iter);
-                dbus_message_iter_append_basic(&variant_iter, DBUS_TYPE_INT32, &value);
-                dbus_message_iter_close_container(&iter, &variant_iter);
-
-                return true;
+                return PropertyClient::appendSetArgs(method_call, this->interface_name, property_name, DBUS_TYPE_INT32, &value);
             },
-            [&property_name, &value](DBusMessage* reply) {
+            [&property_name, &value](DBusMessage* /*reply*/) {
                 std::cout << "[SET] " << property_name << " = " << value << " (success)" << std::endl;
             });
     }
@@ -139,23 +109,435 @@ public:
             this->properties_interface,
             "Set",
             [this, &property_name, &value](DBusMessage* method_call) {
-                const char* interface = this->interface_name;
-                DBusMessageIter iter, variant_iter;
+                return PropertyClient::appendSetArgs(method_call, this->interface_name, property_name, DBUS_TYPE_STRING, &value);
+            },
+            [&property_name, &value](DBusMessage* /*reply*/) {
+                std::cout << "[SET] " << property_name << " = " << value << " (success)" << std::endl;
+            });
+    }
 
-                dbus_message_iter_init_append(method_call, &iter);
-                dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
-                dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &property_name);
-                
-                dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT, "s", &variant_iter);
-                dbus_message_iter_append_basic(&variant_iter, DBUS_TYPE_STRING, &value);
-                dbus_message_iter_close_container(&iter, &variant_iter);
+public:
+    //
+    // Non-blocking versions (call waitPending() to collect the replies)
+    // property_name / value must stay valid until the reply is handled
+    //
 
-                return true;
+    std::future<bool> getIntPropertyAsync(const char* property_name) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->properties_interface,
+            "Get",
+            [this, property_name](DBusMessage* method_call) {
+                return PropertyClient::appendGetArgs(method_call, this->interface_name, property_name);
+            },
+            [property_name](DBusMessage* reply) {
+                PropertyClient::parseIntReply(reply, property_name);
+            });
+    }
+
+    std::future<bool> getStringPropertyAsync(const char* property_name) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->properties_interface,
+            "Get",
+            [this, property_name](DBusMessage* method_call) {
+                return PropertyClient::appendGetArgs(method_call, this->interface_name, property_name);
+            },
+            [property_name](DBusMessage* reply) {
+                PropertyClient::parseStringReply(reply, property_name);
+            });
+    }
+
+    std::future<bool> setIntPropertyAsync(const char* property_name, int32_t value) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->properties_interface,
+            "Set",
+            [this, property_name, value](DBusMessage* method_call) {
+                return PropertyClient::appendSetArgs(method_call, this->interface_name, property_name, DBUS_TYPE_INT32, &value);
+            },
+            [property_name, value](DBusMessage* /*reply*/) {
+                std::cout << "[SET] " << property_name << " = " << value << " (success)" << std::endl;
+            });
+    }
+
+    std::future<bool> setStringPropertyAsync(const char* property_name, const char* value) {
+        return DBusClient::callMethodAsync(
+            this->service_name,
+            this->object_path,
+            this->properties_interface,
+            "Set",
+            [this, property_name, value](DBusMessage* method_call) {
+                return PropertyClient::appendSetArgs(method_call, this->interface_name, property_name, DBUS_TYPE_STRING, &value);
             },
-            [&property_name, &value](DBusMessage* reply) {
+            [property_name, value](DBusMessage* /*reply*/) {
                 std::cout << "[SET] " << property_name << " = " << value << " (success)" << std::endl;
             });
     }
+
+public:
+    //
+    // Batch: one Get per property, all written at once (about one round trip)
+    //
+
+    // false if any read failed or timed out (each failure is printed)
+    bool getProperties(const std::vector<const char*>& property_names, int timeout_ms = DBUS_TIMEOUT_USE_DEFAULT) {
+        DBusCallBatch batch(this->conn, this->dispatcher);
+        for (const char* property_name : property_names) {
+            batch.add(
+                this->service_name,
+                this->object_path,
+                this->properties_interface,
+                "Get",
+                [this, property_name](DBusMessage* method_call) {
+                    return PropertyClient::appendGetArgs(method_call, this->interface_name, property_name);
+                },
+                [property_name](DBusMessage* reply) {
+                    PropertyClient::parseAnyReply(reply, property_name);
+                });
+        }
+
+        const bool all_ok = batch.run(timeout_ms);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const DBusCallBatch::Result& result = batch.results()[i];
+            if (false == result.ok()) {
+                std::cerr << "[GET] " << property_names[i] << " failed: "
+                          << result.error_name << " " << result.error_message << std::endl;
+            }
+        }
+        return all_ok;
+    }
+
+public:
+    //
+    // Cache
+    //
+    // Loads every value once (GetAll) and applies PropertiesChanged as it
+    // arrives; cached reads take a shared lock and never leave the process.
+    // A miss (property not in GetAll yet, or GetAll returned nothing) falls
+    // back to one Get and is cached.
+    //
+
+    // bus_type: bus the service is on (a private connection is opened on it)
+    bool enableCache(DBusBusType bus_type = DBUS_BUS_SESSION) {
+        if (this->cache_running) {
+            return true;
+        }
+
+        // The listener thread and the caller use libdbus concurrently
+        dbus_threads_init_default();
+
+        DBusError error;
+        dbus_error_init(&error);
+        if ( nullptr == (this->signal_conn = dbus_bus_get_private(bus_type, &error)) ) {
+            std::cerr << "Cache Error: " << error.message << std::endl;
+            dbus_error_free(&error);
+            return false;
+        }
+        dbus_connection_set_exit_on_disconnect(this->signal_conn, false);
+
+        // Subscribe before loading, so no change can slip in between
+        const std::string rule =
+            std::string("type='signal',sender='") + this->service_name +
+            "',path='" + this->object_path +
+            "',interface='" + this->properties_interface +
+            "',member='PropertiesChanged',arg0='" + this->interface_name + "'";
+        dbus_bus_add_match(this->signal_conn, rule.c_str(), &error);
+        if ( dbus_error_is_set(&error)
+            || false == dbus_connection_add_filter(this->signal_conn, PropertyClient::onPropertiesChanged, this, nullptr) ) {
+            std::cerr << "Cache Error: " << (dbus_error_is_set(&error) ? error.message : "add filter") << std::endl;
+            dbus_error_free(&error);
+            dbus_connection_close(this->signal_conn);
+            dbus_connection_unref(this->signal_conn);
+            this->signal_conn = nullptr;
+            return false;
+        }
+
+        this->cache_running = true;
+        this->cache_thread = std::thread( [this] () {
+            // Short timeout so disableCache() is noticed
+            while (this->cache_running
+                && dbus_connection_read_write_dispatch(this->signal_conn, 100)) {
+            }
+        } );
+
+        // Initial load
+        size_t loaded = 0;
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->properties_interface,
+            "GetAll",
+            [this](DBusMessage* method_call) {
+                return DBusArgs<const char*>::append(method_call, this->interface_name);
+            },
+            [this, &loaded](DBusMessage* reply) {
+                DBusMessageIter iter;
+                if (dbus_message_iter_init(reply, &iter)) {
+                    loaded = this->PropertyClient::applyChanged(&iter, false);
+                }
+            });
+        // GetAll failed or came back empty (a service whose GetAll has no
+        // body): the cache starts cold and fills one Get per property
+        if (0 == loaded) {
+            std::cerr << "[CACHE] GetAll returned no properties; falling back to one Get per property on first read" << std::endl;
+        }
+        return true;
+    }
+
+    void disableCache() {
+        if (false == this->cache_running.exchange(false)) {
+            return;
+        }
+        this->cache_thread.join();
+
+        dbus_connection_remove_filter(this->signal_conn, PropertyClient::onPropertiesChanged, this);
+        dbus_connection_close(this->signal_conn);
+        dbus_connection_unref(this->signal_conn);
+        this->signal_conn = nullptr;
+
+        std::unique_lock<std::shared_mutex> lock(this->cache_mutex);
+        this->cache.clear();
+    }
+
+    bool getCachedIntProperty(const char* property_name, int32_t& value) {
+        CachedValue cached;
+        if ( false == this->PropertyClient::lookup(property_name, cached)
+            || false == std::holds_alternative<int32_t>(cached) ) {
+            return false;
+        }
+        value = std::get<int32_t>(cached);
+        return true;
+    }
+
+    bool getCachedStringProperty(const char* property_name, std::string& value) {
+        CachedValue cached;
+        if ( false == this->PropertyClient::lookup(property_name, cached)
+            || false == std::holds_alternative<std::string>(cached) ) {
+            return false;
+        }
+        value = std::move(std::get<std::string>(cached));
+        return true;
+    }
+
+private:
+    bool lookup(const char* property_name, CachedValue& value) {
+        {
+            std::shared_lock<std::shared_mutex> lock(this->cache_mutex);
+            auto it = this->cache.find(std::string_view(property_name));
+            if (it != this->cache.end()) {
+                value = it->second;
+                return true;
+            }
+        }
+        if (false == this->cache_running) {
+            return false;
+        }
+
+        // Miss: one round trip, then cached
+        bool found = false;
+        DBusClient::callMethod(
+            this->service_name,
+            this->object_path,
+            this->properties_interface,
+            "Get",
+            [this, property_name](DBusMessage* method_call) {
+                return PropertyClient::appendGetArgs(method_call, this->interface_name, property_name);
+            },
+            [this, property_name, &value, &found](DBusMessage* reply) {
+                DBusMessageIter iter, variant_iter;
+                if ( false == dbus_message_iter_init(reply, &iter)
+                    || DBUS_TYPE_VARIANT != dbus_message_iter_get_arg_type(&iter) ) {
+                    return;
+                }
+                dbus_message_iter_recurse(&iter, &variant_iter);
+                if ( false == PropertyClient::readVariant(&variant_iter, value) ) {
+                    return;
+                }
+                found = true;
+
+                // A PropertiesChanged that got here first is newer
+                std::unique_lock<std::shared_mutex> lock(this->cache_mutex);
+                this->cache.emplace(property_name, value);
+            });
+        return found;
+    }
+
+    // a{sv}; overwrite = false keeps entries already set by a signal.
+    // Returns the number of entries read.
+    size_t applyChanged(DBusMessageIter* iter, bool overwrite) {
+        if (DBUS_TYPE_ARRAY != dbus_message_iter_get_arg_type(iter)) {
+            return 0;
+        }
+
+        size_t count = 0;
+        DBusMessageIter array_iter;
+        dbus_message_iter_recurse(iter, &array_iter);
+        std::unique_lock<std::shared_mutex> lock(this->cache_mutex);
+        for (; DBUS_TYPE_DICT_ENTRY == dbus_message_iter_get_arg_type(&array_iter); dbus_message_iter_next(&array_iter)) {
+            DBusMessageIter entry_iter, variant_iter;
+            const char* property_name = nullptr;
+            CachedValue value;
+
+            dbus_message_iter_recurse(&array_iter, &entry_iter);
+            dbus_message_iter_get_basic(&entry_iter, &property_name);
+            dbus_message_iter_next(&entry_iter);
+            dbus_message_iter_recurse(&entry_iter, &variant_iter);
+            if ( false == PropertyClient::readVariant(&variant_iter, value) ) {
+                continue;
+            }
+
+            if (overwrite) {
+                this->cache[property_name] = std::move(value);
+            } else {
+                this->cache.emplace(property_name, std::move(value));
+            }
+            ++count;
+        }
+        return count;
+    }
+
+    // as
+    void applyInvalidated(DBusMessageIter* iter) {
+        if (DBUS_TYPE_ARRAY != dbus_message_iter_get_arg_type(iter)) {
+            return;
+        }
+
+        DBusMessageIter array_iter;
+        dbus_message_iter_recurse(iter, &array_iter);
+        std::unique_lock<std::shared_mutex> lock(this->cache_mutex);
+        for (; DBUS_TYPE_STRING == dbus_message_iter_get_arg_type(&array_iter); dbus_message_iter_next(&array_iter)) {
+            const char* property_name = nullptr;
+            dbus_message_iter_get_basic(&array_iter, &property_name);
+            auto it = this->cache.find(std::string_view(property_name));
+            if (it != this->cache.end()) {
+                this->cache.erase(it);
+            }
+        }
+    }
+
+    // PropertiesChanged(s interface, a{sv} changed, as invalidated)
+    static DBusHandlerResult onPropertiesChanged(DBusConnection* /*dc*/, DBusMessage* message, void* user_data) {
+        PropertyClient* self = static_cast<PropertyClient*>(user_data);
+        if ( false == dbus_message_is_signal(message, self->properties_interface, "PropertiesChanged")
+            || false == dbus_message_has_signature(message, "sa{sv}as") ) {
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+
+        DBusMessageIter iter;
+        const char* changed_interface = nullptr;
+        dbus_message_iter_init(message, &iter);
+        dbus_message_iter_get_basic(&iter, &changed_interface);
+        if (0 != std::strcmp(changed_interface, self->interface_name)) {
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+
+        dbus_message_iter_next(&iter);
+        self->PropertyClient::applyChanged(&iter, true);
+        dbus_message_iter_next(&iter);
+        self->PropertyClient::applyInvalidated(&iter);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+
+    // v -> int32 / string
+    static bool readVariant(DBusMessageIter* variant_iter, CachedValue& value) {
+        switch (dbus_message_iter_get_arg_type(variant_iter)) {
+        case DBUS_TYPE_INT32: {
+            int32_t number;
+            dbus_message_iter_get_basic(variant_iter, &number);
+            value = number;
+            return true;
+        }
+        case DBUS_TYPE_STRING: {
+            const char* str;
+            dbus_message_iter_get_basic(variant_iter, &str);
+            value = std::string(str);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+private:
+    // Get(ss)
+    static bool appendGetArgs(DBusMessage* method_call, const char* interface, const char* property_name) {
+        if (!DBusArgs<const char*, const char*>::append(method_call, interface, property_name)) {
+            std::cerr << "ERROR: Unable to append arguments!" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Set(ssv)
+    static bool appendSetArgs(DBusMessage* method_call, const char* interface, const char* property_name, int type, const void* value) {
+        const char signature[2] = { static_cast<char>(type), '\0' };
+        DBusMessageIter iter, variant_iter;
+
+        dbus_message_iter_init_append(method_call, &iter);
+        dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
+        dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &property_name);
+
+        dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT, signature, &variant_iter);
+        dbus_message_iter_append_basic(&variant_iter, type, value);
+        dbus_message_iter_close_container(&iter, &variant_iter);
+
+        return true;
+    }
+
+    // v (int)
+    static void parseIntReply(DBusMessage* reply, const char* property_name) {
+        DBusMessageIter iter, variant_iter;
+        int32_t value;
+
+        if (!dbus_message_iter_init(reply, &iter)) {
+            std::cerr << "ERROR: Reply has no arguments!" << std::endl;
+            return;
+        }
+
+        dbus_message_iter_recurse(&iter, &variant_iter);
+        if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_INT32) {
+            dbus_message_iter_get_basic(&variant_iter, &value);
+            std::cout << "[GET] " << property_name << " = " << value << std::endl;
+        } else {
+            std::cerr << "ERROR: Unexpected property type!" << std::endl;
+        }
+    }
+
+    // v (int or string)
+    static void parseAnyReply(DBusMessage* reply, const char* property_name) {
+        DBusMessageIter iter, variant_iter;
+        if ( dbus_message_iter_init(reply, &iter) ) {
+            dbus_message_iter_recurse(&iter, &variant_iter);
+            if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_INT32) {
+                PropertyClient::parseIntReply(reply, property_name);
+                return;
+            }
+        }
+        PropertyClient::parseStringReply(reply, property_name);
+    }
+
+    // v (string)
+    static void parseStringReply(DBusMessage* reply, const char* property_name) {
+        DBusMessageIter iter, variant_iter;
+        const char* value;
+
+        if (!dbus_message_iter_init(reply, &iter)) {
+            std::cerr << "ERROR: Reply has no arguments!" << std::endl;
+            return;
+        }
+
+        dbus_message_iter_recurse(&iter, &variant_iter);
+        if (dbus_message_iter_get_arg_type(&variant_iter) == DBUS_TYPE_STRING) {
+            dbus_message_iter_get_basic(&variant_iter, &value);
+            std::cout << "[GET] " << property_name << " = " << value << std::endl;
+        } else {
+            std::cerr << "ERROR: Unexpected property type!" << std::endl;
+        }
+    }
 };
 
 //
@@ -182,12 +564,9 @@ int main() {
     std::cout << "=== Property Client ===" << std::endl;
     std::cout << std::endl;
 
-    // Get initial values
+    // Get initial values (one batch instead of one round trip each)
     std::cout << "--- Getting Initial Properties ---" << std::endl;
-    client.getIntProperty("Temperature");
-    client.getIntProperty("Brightness");
-    client.getStringProperty("DeviceName");
-    client.getStringProperty("Status");
+    client.getProperties({ "Temperature", "Brightness", "DeviceName", "Status" }, 2000);
     std::cout << std::endl;
 
     // Set new values
@@ -206,6 +585,59 @@ int main() {
     client.getStringProperty("Status");
     std::cout << std::endl;
 
+    // Pipelined reads (all in flight on one connection)
+    std::cout << "--- Getting Properties (pipelined) ---" << std::endl;
+    client.getIntPropertyAsync("Temperature");
+    client.getIntPropertyAsync("Brightness");
+    client.getStringPropertyAsync("DeviceName");
+    client.getStringPropertyAsync("Status");
+    client.waitPending();
+    std::cout << std::endl;
+
+    // Cached reads (kept current by PropertiesChanged)
+    std::cout << "--- Cached Properties ---" << std::endl;
+    if (client.enableCache(DBUS_BUS_SESSION)) {
+        int32_t temperature = 0;
+        const int reads = 1000000;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < reads; ++i) {
+            client.getCachedIntProperty("Temperature", temperature);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "[CACHE] Temperature = " << temperature
+                  << " (" << reads << " reads, " << (elapsed / reads) << " ns/read)" << std::endl;
+
+        // Change it and watch the cache follow
+        client.setIntProperty("Temperature", 42);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (client.getCachedIntProperty("Temperature", temperature) && 42 != temperature
+            && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::cout << "[CACHE] Temperature = " << temperature << " (after PropertiesChanged)" << std::endl;
+
+        // Burst of writes: the service coalesces them into a few signals
+        // carrying the latest value
+        std::vector<std::future<bool>> burst;
+        for (int32_t i = 1; i <= 20; ++i) {
+            burst.push_back(client.setIntPropertyAsync("Temperature", i));
+        }
+        client.waitPending();
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (client.getCachedIntProperty("Temperature", temperature) && 20 != temperature
+            && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::cout << "[CACHE] Temperature = " << temperature << " (after 20 Sets)" << std::endl;
+
+        std::string status;
+        if (client.getCachedStringProperty("Status", status)) {
+            std::cout << "[CACHE] Status = " << status << std::endl;
+        }
+        client.disableCache();
+    }
+    std::cout << std::endl;
+
     // Cleanup
     dbus_connection_unref(connection);
 
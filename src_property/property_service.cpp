@@ -1,68 +1,994 @@
 #include <iostream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <functional>
 #include <map>
+#include <memory_resource>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "../include/dbus_conn_wrapper.hpp"
 #include "../include/dbus_server_wrapper.hpp"
+#include "../include/dbus_router.hpp"
+#include "../include/dbus_args.hpp"
+#include "../include/dbus_logger.hpp"
+
+//
+// Snapshot File
+//
+// Optional persistence (PROPERTY_SNAPSHOT_FILE): the whole property set is
+// kept in a memory-mapped file of fixed-size binary records, so a restart
+// maps it and serves the saved values without parsing anything.
+//
+// Commit protocol: the file has two slots. A write fills the slot that is
+// not current with the complete new state, its sequence number and a CRC,
+// then msyncs that slot. On load the valid slot (CRC matches) with the
+// highest sequence wins, so a crash in the middle of a write falls back to
+// the previous complete state.
+
+class PropertySnapshotFile {
+public:
+    using IntMap = std::map<std::string, int32_t, std::less<>>;
+    using StringMap = std::map<std::string, std::string, std::less<>>;
+
+    static constexpr size_t kMaxRecords = 64;
+    static constexpr size_t kNameSize = 32;    // incl. NUL
+    static constexpr size_t kValueSize = 96;   // incl. NUL
+
+private:
+    struct Record {
+        char name[kNameSize];
+        uint8_t type;              // DBUS_TYPE_INT32 / DBUS_TYPE_STRING
+        uint8_t reserved[3];
+        int32_t int_value;
+        char str_value[kValueSize];
+    };
+    struct Slot {
+        uint64_t seq;
+        uint32_t crc;              // over count + records
+        uint32_t count;
+        Record records[kMaxRecords];
+    };
+    struct Layout {
+        char magic[8];             // "PROPSNAP"
+        uint32_t version;
+        uint32_t slot_size;
+        Slot slots[2];
+    };
+
+private:
+    int fd;
+    Layout* layout;
+    // Slot holding the current state
+    int current;
+    // Slot last known to be on disk (msynced); never written by a commit
+    // that skips msync, so it survives until the next durable one
+    int durable_slot;
+
+public:
+    // Constructor (maps the file, creating it if needed)
+    PropertySnapshotFile(const char* path) : fd(-1), layout(nullptr), current(-1), durable_slot(-1)
+    {
+        if ( 0 > (fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) ) {
+            std::cerr << "Snapshot Error: open " << path << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if ( 0 != ftruncate(fd, sizeof(Layout)) ) {
+            std::cerr << "Snapshot Error: ftruncate: " << std::strerror(errno) << std::endl;
+            goto FAIL;
+        }
+
+        {
+            void* addr = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (MAP_FAILED == addr) {
+                std::cerr << "Snapshot Error: mmap: " << std::strerror(errno) << std::endl;
+                goto FAIL;
+            }
+            layout = static_cast<Layout*>(addr);
+        }
+
+        // New (or foreign) file: start empty, both slots invalid
+        if ( 0 != std::memcmp(layout->magic, "PROPSNAP", 8)
+            || 1 != layout->version
+            || sizeof(Slot) != layout->slot_size ) {
+            std::memset(static_cast<void*>(layout), 0, sizeof(Layout));
+            std::memcpy(layout->magic, "PROPSNAP", 8);
+            layout->version = 1;
+            layout->slot_size = sizeof(Slot);
+            msync(layout, sizeof(Layout), MS_SYNC);
+            return;
+        }
+
+        for (int i = 0; i < 2; ++i) {
+            if ( PropertySnapshotFile::isValid(layout->slots[i])
+                && (current < 0 || layout->slots[i].seq > layout->slots[current].seq) ) {
+                current = i;
+            }
+        }
+        // A slot the last run left unsynced may still be only in the page cache
+        if (current >= 0 && 0 == msync(layout, sizeof(Layout), MS_SYNC)) {
+            durable_slot = current;
+        }
+        return;
+
+FAIL:
+        close(fd);
+        fd = -1;
+    }
+    // delete
+    PropertySnapshotFile() = delete;
+    PropertySnapshotFile(PropertySnapshotFile&& other) = delete;
+    PropertySnapshotFile& operator=(PropertySnapshotFile&& other) = delete;
+    PropertySnapshotFile(const PropertySnapshotFile&) = delete;
+    PropertySnapshotFile& operator=(const PropertySnapshotFile&) = delete;
+    // De-Constructor
+    ~PropertySnapshotFile() {
+        if (layout) {
+            munmap(layout, sizeof(Layout));
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+public:
+    bool isOpen() const {
+        return nullptr != layout;
+    }
+
+    // false if there is no saved state
+    bool load(IntMap& int_properties, StringMap& string_properties, uint64_t& seq) const {
+        if (nullptr == layout || current < 0) {
+            return false;
+        }
+
+        const Slot& slot = layout->slots[current];
+        int_properties.clear();
+        string_properties.clear();
+        for (uint32_t i = 0; i < slot.count; ++i) {
+            // Bounded by the field size: the CRC does not prove a terminating NUL
+            const Record& record = slot.records[i];
+            std::string name(record.name, strnlen(record.name, kNameSize));
+            if (DBUS_TYPE_INT32 == record.type) {
+                int_properties[std::move(name)] = record.int_value;
+            } else {
+                string_properties[std::move(name)] = std::string(record.str_value, strnlen(record.str_value, kValueSize));
+            }
+        }
+        seq = slot.seq;
+        return true;
+    }
+
+    // Whether a state fits the fixed record layout
+    static bool fits(const IntMap& int_properties, const StringMap& string_properties) {
+        if (int_properties.size() + string_properties.size() > kMaxRecords) {
+            return false;
+        }
+        for (const auto& p : int_properties) {
+            if (p.first.size() >= kNameSize) {
+                return false;
+            }
+        }
+        for (const auto& p : string_properties) {
+            if (p.first.size() >= kNameSize || p.second.size() >= kValueSize) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Write the complete state into the other slot and make it current
+    // (callers serialize commits)
+    // durable = false skips the msync (when a journal provides durability):
+    // such commits keep rewriting the slot that is not on disk, so the last
+    // durable slot (the journal's checkpoint) is never torn or overtaken
+    bool commit(const IntMap& int_properties, const StringMap& string_properties, uint64_t seq, bool durable = true) {
+        if (nullptr == layout || false == PropertySnapshotFile::fits(int_properties, string_properties)) {
+            return false;
+        }
+
+        const int other = (0 == current) ? 1 : 0;
+        const int target = (false == durable && current >= 0 && current != durable_slot) ? current : other;
+        Slot& slot = layout->slots[target];
+
+        uint32_t n = 0;
+        for (const auto& p : int_properties) {
+            Record& record = slot.records[n++];
+            std::memset(&record, 0, sizeof(Record));
+            std::memcpy(record.name, p.first.data(), p.first.size());
+            record.type = DBUS_TYPE_INT32;
+            record.int_value = p.second;
+        }
+        for (const auto& p : string_properties) {
+            Record& record = slot.records[n++];
+            std::memset(&record, 0, sizeof(Record));
+            std::memcpy(record.name, p.first.data(), p.first.size());
+            record.type = DBUS_TYPE_STRING;
+            std::memcpy(record.str_value, p.second.data(), p.second.size());
+        }
+        slot.count = n;
+        slot.seq = seq;
+        slot.crc = PropertySnapshotFile::checksum(slot);
+
+        // Durable before it can be picked as the newest slot
+        if ( durable && 0 != PropertySnapshotFile::syncRange(&slot, sizeof(Slot)) ) {
+            std::cerr << "Snapshot Error: msync: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        current = target;
+        if (durable) {
+            durable_slot = target;
+        }
+        return true;
+    }
+
+public:
+    // CRC-32 (IEEE) step, start with 0xFFFFFFFF and invert the result
+    static uint32_t crc32(uint32_t crc, const void* data, size_t size) {
+        static const auto table = [] () {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    // Force the current slot to disk (after commits that skipped msync);
+    // it becomes the slot later non-durable commits leave alone
+    bool flush() {
+        if (nullptr == layout || 0 != msync(layout, sizeof(Layout), MS_SYNC)) {
+            return false;
+        }
+        durable_slot = current;
+        return true;
+    }
+
+private:
+    static bool isValid(const Slot& slot) {
+        return slot.count <= kMaxRecords && slot.crc == PropertySnapshotFile::checksum(slot);
+    }
+
+    // CRC-32 (IEEE) of seq, count and the used records
+    static uint32_t checksum(const Slot& slot) {
+        uint32_t crc = 0xFFFFFFFFu;
+        crc = PropertySnapshotFile::crc32(crc, &slot.seq, sizeof(slot.seq));
+        crc = PropertySnapshotFile::crc32(crc, &slot.count, sizeof(slot.count));
+        const size_t count = (slot.count <= kMaxRecords) ? slot.count : kMaxRecords;
+        crc = PropertySnapshotFile::crc32(crc, slot.records, count * sizeof(Record));
+        return ~crc;
+    }
+
+    // msync wants a page aligned start
+    static int syncRange(void* addr, size_t size) {
+        const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(addr) + size;
+        return msync(reinterpret_cast<void*>(begin), end - begin, MS_SYNC);
+    }
+};
+
+//
+// Journal
+//
+// Optional write-ahead log (PROPERTY_JOURNAL_FILE): every Set appends one
+// record, replayed on top of the saved / default state at startup.
+//
+// Group commit: append() only buffers. sync() makes everything appended so
+// far durable with one write + fdatasync; callers that arrive while another
+// thread is syncing wait for it and are usually covered by the same flush
+// (leader / follower), so concurrent Sets share one fdatasync.
+//
+// A failed write or fdatasync is final: the file is cut back to its last
+// durable length and every record not durable by then fails, as does every
+// later sync (after a failed fdatasync the kernel may have dropped the
+// dirty pages, so nothing written since can be trusted). Restart to recover.
+//
+// Record: u32 crc | u16 name length | u16 value length | u8 type | name | value
+// (crc covers everything after it; a torn tail is cut off at replay, a bad
+// record with intact ones behind it is corruption: the file is kept aside)
+
+class PropertyJournal {
+public:
+    // Longest name / value a record can hold
+    static constexpr size_t kMaxFieldSize = UINT16_MAX;
+private:
+    static constexpr size_t kHeaderSize = 9;
+private:
+    std::string path;
+    int fd;
+    std::mutex mutex;
+    std::condition_variable synced;
+    std::string pending;
+    uint64_t appended;
+    uint64_t durable;
+    bool syncing;
+    bool failed;
+    // Durable length of the file
+    off_t size;
+    // Truncate once the file grows past this (only when a checkpoint is possible:
+    // without a snapshot file the journal is the only copy and is never compacted)
+    off_t compact_bytes;
+
+public:
+    // Constructor
+    PropertyJournal(const char* journal_path, off_t compact_threshold = 1 << 20) :
+        path(journal_path),
+        fd(-1),
+        appended(0),
+        durable(0),
+        syncing(false),
+        failed(false),
+        size(0),
+        compact_bytes(compact_threshold)
+    {
+        if ( 0 > (fd = open(journal_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) ) {
+            std::cerr << "Journal Error: open " << journal_path << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+    // delete
+    PropertyJournal() = delete;
+    PropertyJournal(PropertyJournal&& other) = delete;
+    PropertyJournal& operator=(PropertyJournal&& other) = delete;
+    PropertyJournal(const PropertyJournal&) = delete;
+    PropertyJournal& operator=(const PropertyJournal&) = delete;
+    // De-Constructor
+    ~PropertyJournal() {
+        if (fd >= 0) {
+            this->PropertyJournal::sync();
+            close(fd);
+        }
+    }
+
+public:
+    bool isOpen() const {
+        return fd >= 0;
+    }
+
+    // A write or fdatasync failed: nothing appended can become durable
+    bool isFailed() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+
+    // Whether a change can be journaled (lengths are stored in 16 bits)
+    static bool fits(std::string_view name, size_t value_size) {
+        return name.size() <= kMaxFieldSize && value_size <= kMaxFieldSize;
+    }
+
+    // Apply every intact record in order; returns the number applied.
+    // Stops at the first bad record: a torn tail is cut off, a bad record
+    // followed by intact ones is reported as corruption and the file is
+    // moved to <path>.corrupt (the journal starts over with the good prefix).
+    size_t replay(const std::function<void(int, std::string_view, std::string_view)>& apply) {
+        std::string data;
+        char chunk[4096];
+        ssize_t n;
+        lseek(fd, 0, SEEK_SET);
+        while ( 0 < (n = read(fd, chunk, sizeof(chunk))) ) {
+            data.append(chunk, n);
+        }
+
+        size_t offset = 0;
+        size_t count = 0;
+        size_t record_size = 0;
+        while ( 0 != (record_size = PropertyJournal::recordAt(data, offset)) ) {
+            const char* record = data.data() + offset;
+            uint16_t name_size, value_size;
+            std::memcpy(&name_size, record + 4, 2);
+            std::memcpy(&value_size, record + 6, 2);
+            apply(static_cast<uint8_t>(record[8]),
+                  std::string_view(record + kHeaderSize, name_size),
+                  std::string_view(record + kHeaderSize + name_size, value_size));
+            offset += record_size;
+            ++count;
+        }
+
+        // Intact records behind the bad one: not a torn write, keep the evidence
+        for (size_t next = offset + 1; offset < data.size() && next + kHeaderSize <= data.size(); ++next) {
+            if (0 == PropertyJournal::recordAt(data, next)) {
+                continue;
+            }
+            const std::string corrupt_path = path + ".corrupt";
+            std::cerr << "Journal Error: corrupt record at offset " << offset << " of " << path
+                      << " followed by intact data; " << (data.size() - offset) << " byte(s) not replayed, file kept as "
+                      << corrupt_path << std::endl;
+            if ( 0 != rename(path.c_str(), corrupt_path.c_str()) ) {
+                std::cerr << "Journal Error: rename: " << std::strerror(errno) << std::endl;
+            }
+            // Start over with the records that were applied
+            close(fd);
+            if ( 0 > (fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644))
+                || false == PropertyJournal::writeAll(fd, data.data(), offset)
+                || 0 != fdatasync(fd) ) {
+                std::cerr << "Journal Error: " << path << ": " << std::strerror(errno) << std::endl;
+            }
+            size = static_cast<off_t>(offset);
+            return count;
+        }
+
+        // Cut off a torn tail so new records follow the last good one
+        if (offset < data.size()) {
+            std::cerr << "Journal: dropping " << (data.size() - offset) << " byte(s) of torn tail" << std::endl;
+            if (0 != ftruncate(fd, offset)) {
+                std::cerr << "Journal Error: ftruncate: " << std::strerror(errno) << std::endl;
+            }
+        }
+        size = static_cast<off_t>(offset);
+        return count;
+    }
+
+    // Buffer one record (not durable until sync()); callers check fits() first.
+    // Returns its sequence number (see durableSeq()).
+    uint64_t append(int type, std::string_view name, const void* value, size_t value_size) {
+        char header[kHeaderSize];
+        const uint16_t name_size16 = static_cast<uint16_t>(name.size());
+        const uint16_t value_size16 = static_cast<uint16_t>(value_size);
+        std::memcpy(header + 4, &name_size16, 2);
+        std::memcpy(header + 6, &value_size16, 2);
+        header[8] = static_cast<char>(type);
+
+        std::string record(header, kHeaderSize);
+        record.append(name.data(), name.size());
+        record.append(static_cast<const char*>(value), value_size);
+        const uint32_t crc = PropertyJournal::checksum(record.data() + 4, record.size() - 4);
+        std::memcpy(&record[0], &crc, 4);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pending += record;
+        return ++appended;
+    }
+
+    // Records up to this sequence number are durable
+    uint64_t durableSeq() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return durable;
+    }
+
+    // Make everything appended so far durable (one fdatasync per group).
+    // false if one of these records did not make it (see above).
+    bool sync() {
+        uint64_t target;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            target = appended;
+        }
+        return this->PropertyJournal::sync(target);
+    }
+
+    // Same, for the records up to sequence number target (the flush still
+    // takes everything appended by then)
+    bool sync(uint64_t target) {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool ok = true;
+        while (durable < target) {
+            // durable never moves past a group that failed
+            if (failed) {
+                return false;
+            }
+            // Follower: somebody is flushing, it may cover us
+            if (syncing) {
+                synced.wait(lock);
+                continue;
+            }
+
+            // Leader: flush the whole group
+            syncing = true;
+            std::string batch;
+            batch.swap(pending);
+            const uint64_t upto = appended;
+            lock.unlock();
+
+            ok = PropertyJournal::writeAll(fd, batch.data(), batch.size()) && 0 == fdatasync(fd);
+            if (false == ok) {
+                std::cerr << "Journal Error: " << std::strerror(errno) << std::endl;
+            }
+
+            lock.lock();
+            syncing = false;
+            if (false == ok) {
+                // No torn record in the middle of the file for later ones to follow
+                failed = true;
+                pending.clear();
+                if (0 != ftruncate(fd, size)) {
+                    std::cerr << "Journal Error: ftruncate: " << std::strerror(errno) << std::endl;
+                }
+                std::cerr << "Journal Error: " << path << " failed, Sets are refused until restart" << std::endl;
+            }
+            else {
+                durable = upto;
+                size += static_cast<off_t>(batch.size());
+            }
+            synced.notify_all();
+            if (false == ok) {
+                return false;
+            }
+        }
+        return ok;
+    }
+
+    // Truncate the file once it is past the threshold, if covered (the
+    // sequence number the checkpointed state includes) is every record
+    // written so far. checkpoint: makes that state durable elsewhere, must
+    // return true only if it did.
+    bool compact(uint64_t covered, const std::function<bool()>& checkpoint) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // A leader in flight may be writing records the state lacks
+        if (size <= compact_bytes || syncing || failed || durable != covered) {
+            return false;
+        }
+        if (false == checkpoint()) {
+            return false;
+        }
+        if (0 != ftruncate(fd, 0) || 0 != fdatasync(fd)) {
+            std::cerr << "Journal Error: compact: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        size = 0;
+        return true;
+    }
+
+private:
+    // Size of the intact record at offset, 0 if there is none
+    static size_t recordAt(const std::string& data, size_t offset) {
+        if (offset + kHeaderSize > data.size()) {
+            return 0;
+        }
+        const char* record = data.data() + offset;
+        uint32_t crc;
+        uint16_t name_size, value_size;
+        std::memcpy(&crc, record, 4);
+        std::memcpy(&name_size, record + 4, 2);
+        std::memcpy(&value_size, record + 6, 2);
+        const size_t record_size = kHeaderSize + name_size + value_size;
+        if ( offset + record_size > data.size()
+            || (DBUS_TYPE_INT32 != record[8] && DBUS_TYPE_STRING != record[8])
+            || crc != PropertyJournal::checksum(record + 4, record_size - 4) ) {
+            return 0;
+        }
+        return record_size;
+    }
+
+    static bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t n = write(fd, data, size);
+            if (n < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    static uint32_t checksum(const void* data, size_t size) {
+        return ~PropertySnapshotFile::crc32(0xFFFFFFFFu, data, size);
+    }
+};
 
 //
 // Property Storage
 //
+// Readers never lock: the current state is an immutable snapshot behind an
+// atomic pointer (RCU style). A writer copies the snapshot, applies its
+// change, publishes the copy, then waits for the readers that may still hold
+// the old one before deleting it. Writers are serialized by a mutex.
+//
+// Grace period: readers register in one of two counters picked by the epoch
+// parity. The writer flips the epoch after publishing and waits for the old
+// parity counter to drain; readers arriving after the flip can only see the
+// new snapshot.
+//
+// With a journal a Set is staged, not published: the next Set builds on it,
+// but readers (and PropertiesChanged) only see it once syncJournal() has
+// made its record durable. If the journal fails, staged states are dropped,
+// so a Set that was refused never shows up anywhere.
 
 class PropertyStorage {
 private:
-    std::map<std::string, int32_t> int_properties;
-    std::map<std::string, std::string> string_properties;
+    struct Snapshot {
+        PropertySnapshotFile::IntMap int_properties;
+        PropertySnapshotFile::StringMap string_properties;
+        uint64_t generation = 0;
+        // GetAll reply body for this state (method return without serial /
+        // destination); built by the writer, copied by readers
+        DBusMessage* getall = nullptr;
+
+        ~Snapshot() {
+            if (getall) {
+                dbus_message_unref(getall);
+            }
+        }
+    };
+
+    // Pins the snapshot that was current when it was created
+    class ReadGuard {
+    private:
+        const PropertyStorage& storage;
+        unsigned slot;
+    public:
+        const Snapshot* snapshot;
+
+    public:
+        // Constructor
+        ReadGuard(const PropertyStorage& st) : storage(st) {
+            for (;;) {
+                const unsigned epoch = storage.epoch.load();
+                slot = epoch & 1;
+                storage.readers[slot].fetch_add(1);
+                // Retry if a writer flipped in between (it may not wait for us)
+                if (storage.epoch.load() == epoch) {
+                    break;
+                }
+                storage.readers[slot].fetch_sub(1);
+            }
+            snapshot = storage.current.load();
+        }
+        // delete
+        ReadGuard() = delete;
+        ReadGuard(ReadGuard&& other) = delete;
+        ReadGuard& operator=(ReadGuard&& other) = delete;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        // De-Constructor
+        ~ReadGuard() {
+            storage.readers[slot].fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+private:
+    std::atomic<Snapshot*> current;
+    mutable std::atomic<unsigned> epoch;
+    mutable std::atomic<uint64_t> readers[2];
+    std::mutex write_mutex;
+    // Optional persistence (every published snapshot is committed first)
+    std::unique_ptr<PropertySnapshotFile> file;
+    // Optional write-ahead log (appended under write_mutex, so in apply order)
+    std::unique_ptr<PropertyJournal> journal;
+    // Journaled Sets waiting for their record to be durable, oldest first
+    // (under write_mutex)
+    struct Staged {
+        uint64_t seq;
+        Snapshot* snapshot;
+        std::string name;
+    };
+    std::deque<Staged> staged;
 
 public:
-    PropertyStorage() {
-        // Initialize with default values
-        int_properties["Temperature"] = 25;
-        int_properties["Brightness"] = 80;
-        string_properties["DeviceName"] = "PropertyDevice";
-        string_properties["Status"] = "Ready";
+    // snapshot_path: mapped file to restore from / persist to (nullptr = memory only)
+    // journal_path: write-ahead log replayed at startup (nullptr = none)
+    PropertyStorage(const char* snapshot_path = nullptr, const char* journal_path = nullptr) :
+        current(nullptr), epoch(0), readers{ {0}, {0} }
+    {
+        Snapshot* initial = new Snapshot();
+
+        if (snapshot_path && *snapshot_path) {
+            file.reset(new PropertySnapshotFile(snapshot_path));
+            if (false == file->isOpen()) {
+                file.reset();
+            }
+        }
+
+        // Restore saved values, else initialize with default values
+        if ( nullptr == file
+            || false == file->load(initial->int_properties, initial->string_properties, initial->generation) ) {
+            initial->int_properties["Temperature"] = 25;
+            initial->int_properties["Brightness"] = 80;
+            initial->string_properties["DeviceName"] = "PropertyDevice";
+            initial->string_properties["Status"] = "Ready";
+            if (file) {
+                file->commit(initial->int_properties, initial->string_properties, initial->generation);
+            }
+        } else {
+            std::cout << "Restored properties from " << snapshot_path << std::endl;
+        }
+
+        // Replay Sets that may be newer than the snapshot
+        if (journal_path && *journal_path) {
+            journal.reset(new PropertyJournal(journal_path));
+            if (false == journal->isOpen()) {
+                journal.reset();
+            }
+            else if (nullptr == file) {
+                std::cerr << "Journal: no snapshot file, " << journal_path
+                          << " holds every Set and is never compacted" << std::endl;
+            }
+        }
+        if (journal) {
+            const size_t replayed = journal->replay( [initial] (int type, std::string_view name, std::string_view value) {
+                if (DBUS_TYPE_INT32 == type && sizeof(int32_t) == value.size()) {
+                    int32_t number;
+                    std::memcpy(&number, value.data(), sizeof(number));
+                    initial->int_properties[std::string(name)] = number;
+                } else if (DBUS_TYPE_STRING == type) {
+                    initial->string_properties[std::string(name)] = std::string(value);
+                }
+            } );
+            if (replayed > 0) {
+                std::cout << "Replayed " << replayed << " journal record(s) from " << journal_path << std::endl;
+                initial->generation += replayed;
+                if (file) {
+                    file->commit(initial->int_properties, initial->string_properties, initial->generation);
+                }
+            }
+        }
+        initial->getall = PropertyStorage::buildGetAll(*initial);
+        current.store(initial);
+    }
+    // delete
+    PropertyStorage(PropertyStorage&& other) = delete;
+    PropertyStorage& operator=(PropertyStorage&& other) = delete;
+    PropertyStorage(const PropertyStorage&) = delete;
+    PropertyStorage& operator=(const PropertyStorage&) = delete;
+    // De-Constructor (no readers left by now)
+    ~PropertyStorage() {
+        for (Staged& change : staged) {
+            delete change.snapshot;
+        }
+        delete current.load();
     }
 
-    bool getIntProperty(const std::string& name, int32_t& value) {
-        auto it = int_properties.find(name);
-        if (it != int_properties.end()) {
+    bool getIntProperty(std::string_view name, int32_t& value) const {
+        ReadGuard guard(*this);
+        auto it = guard.snapshot->int_properties.find(name);
+        if (it != guard.snapshot->int_properties.end()) {
             value = it->second;
             return true;
         }
         return false;
     }
 
-    bool setIntProperty(const std::string& name, int32_t value) {
-        int_properties[name] = value;
-        return true;
+    // Sets become visible in syncJournal(), not in set*Property()
+    bool isJournaled() const {
+        return nullptr != journal;
+    }
+
+    // Whether a Set with this name / value size can be stored (the journal
+    // limits both to PropertyJournal::kMaxFieldSize bytes)
+    bool accepts(std::string_view name, size_t value_size) const {
+        return nullptr == journal || PropertyJournal::fits(name, value_size);
+    }
+
+    bool setIntProperty(std::string_view name, int32_t value) {
+        return this->PropertyStorage::update( [name, value] (Snapshot& next) {
+            next.int_properties[std::string(name)] = value;
+        }, DBUS_TYPE_INT32, name, &value, sizeof(value) );
     }
 
-    bool getStringProperty(const std::string& name, std::string& value) {
-        auto it = string_properties.find(name);
-        if (it != string_properties.end()) {
+    bool getStringProperty(std::string_view name, std::string& value) const {
+        ReadGuard guard(*this);
+        auto it = guard.snapshot->string_properties.find(name);
+        if (it != guard.snapshot->string_properties.end()) {
             value = it->second;
             return true;
         }
         return false;
     }
 
-    bool setStringProperty(const std::string& name, const std::string& value) {
-        string_properties[name] = value;
-        return true;
+    // Same, copying into a caller-chosen allocator (e.g. the request arena)
+    bool getStringProperty(std::string_view name, std::pmr::string& value) const {
+        ReadGuard guard(*this);
+        auto it = guard.snapshot->string_properties.find(name);
+        if (it != guard.snapshot->string_properties.end()) {
+            value.assign(it->second);
+            return true;
+        }
+        return false;
+    }
+
+    bool setStringProperty(std::string_view name, std::string_view value) {
+        return this->PropertyStorage::update( [name, value] (Snapshot& next) {
+            next.string_properties[std::string(name)] = std::string(value);
+        }, DBUS_TYPE_STRING, name, value.data(), value.size() );
+    }
+
+    // Make the calling thread's journaled Sets durable (group commit) and
+    // publish every Set that is; false only if one of this thread's Sets
+    // failed, true without a journal. changed: names of the Sets published here.
+    // Compacts the journal once the snapshot file holds everything (journal
+    // only: no checkpoint, the journal grows with every Set).
+    bool syncJournal(std::vector<std::string>& changed) {
+        if (nullptr == journal) {
+            return true;
+        }
+        const uint64_t target = std::exchange(PropertyStorage::unsyncedSeq(), 0);
+        const bool ok = (0 == target) || journal->sync(target);
+
+        std::lock_guard<std::mutex> lock(write_mutex);
+        const uint64_t durable = journal->durableSeq();
+        Snapshot* newest = nullptr;
+        uint64_t newest_seq = 0;
+        while (false == staged.empty() && staged.front().seq <= durable) {
+            // Superseded before it was ever published
+            delete newest;
+            newest = staged.front().snapshot;
+            newest_seq = staged.front().seq;
+            changed.push_back(std::move(staged.front().name));
+            staged.pop_front();
+        }
+        if (newest) {
+            // The snapshot is a checkpoint: no msync, the journal is durable
+            if (file) {
+                file->commit(newest->int_properties, newest->string_properties, newest->generation, false);
+            }
+            newest->getall = PropertyStorage::buildGetAll(*newest);
+            this->PropertyStorage::publish(newest);
+            if (file) {
+                journal->compact(newest_seq, [this] () { return file->flush(); });
+            }
+        }
+
+        // Nothing still staged can become durable any more
+        if (journal->isFailed()) {
+            for (Staged& change : staged) {
+                delete change.snapshot;
+            }
+            staged.clear();
+        }
+        return ok;
+    }
+
+    uint64_t getGeneration() const {
+        ReadGuard guard(*this);
+        return guard.snapshot->generation;
     }
 
+    // Copy of the prebuilt GetAll body (caller sets serial / destination)
+    DBusMessage* copyGetAll() const {
+        ReadGuard guard(*this);
+        if (nullptr == guard.snapshot->getall) {
+            return nullptr;
+        }
+        return dbus_message_copy(guard.snapshot->getall);
+    }
+
+    // Debug dump of the whole store (callers check the level first)
     void listProperties() const {
-        std::cout << "Integer Properties: ";
-        for (const auto& p : int_properties) {
-            std::cout << p.first << "=" << p.second << " ";
+        ReadGuard guard(*this);
+        std::string line = "Integer Properties: ";
+        for (const auto& p : guard.snapshot->int_properties) {
+            line += p.first + "=" + std::to_string(p.second) + " ";
         }
-        std::cout << std::endl;
-        
-        std::cout << "String Properties: ";
-        for (const auto& p : string_properties) {
-            std::cout << p.first << "=" << p.second << " ";
+        Logger::debug(line);
+
+        line = "String Properties: ";
+        for (const auto& p : guard.snapshot->string_properties) {
+            line += p.first + "=" + p.second + " ";
         }
-        std::cout << std::endl;
+        Logger::debug(line);
+    }
+
+private:
+    // Copy, modify, persist, publish, wait for old readers, free
+    // (type / name / value: the change as journaled). With a journal the
+    // copy is staged instead, see syncJournal().
+    bool update(const std::function<void(Snapshot&)>& modify, int type, std::string_view name, const void* value, size_t value_size) {
+        // Never publish what the journal cannot record
+        if ( false == this->PropertyStorage::accepts(name, value_size)
+            || (journal && journal->isFailed()) ) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(write_mutex);
+
+        // Latest state, staged or published
+        const Snapshot* base = staged.empty() ? current.load() : staged.back().snapshot;
+        Snapshot* next = new Snapshot();
+        next->int_properties = base->int_properties;
+        next->string_properties = base->string_properties;
+        next->generation = base->generation + 1;
+        modify(*next);
+
+        // Journaled: committed to the snapshot file once durable (still
+        // reject here what the record layout cannot hold)
+        if (journal) {
+            if ( file && false == PropertySnapshotFile::fits(next->int_properties, next->string_properties) ) {
+                delete next;
+                return false;
+            }
+            const uint64_t seq = journal->append(type, name, value, value_size);
+            staged.push_back(Staged{ seq, next, std::string(name) });
+            PropertyStorage::unsyncedSeq() = seq;
+            return true;
+        }
+
+        // Persist before publishing (rejects values the record layout cannot hold)
+        if ( file && false == file->commit(next->int_properties, next->string_properties, next->generation) ) {
+            delete next;
+            return false;
+        }
+        next->getall = PropertyStorage::buildGetAll(*next);
+        this->PropertyStorage::publish(next);
+        return true;
+    }
+
+    // Latest record this thread journaled since its last syncJournal(): the
+    // Sets of the batch (or request, with the worker pool) it is handling
+    static uint64_t& unsyncedSeq() {
+        static thread_local uint64_t seq = 0;
+        return seq;
+    }
+
+    // Make next current, wait for old readers, free the old one (under write_mutex)
+    void publish(Snapshot* next) {
+        Snapshot* previous = current.load();
+        current.store(next);
+        this->PropertyStorage::synchronize();
+        delete previous;
+    }
+
+    // Wait until no reader can still hold the previous snapshot
+    void synchronize() {
+        const unsigned old_epoch = epoch.fetch_add(1);
+        while (0 != readers[old_epoch & 1].load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Method return without serial / destination, body a{sv}
+    static DBusMessage* buildGetAll(const Snapshot& snapshot) {
+        DBusMessage* body = dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_RETURN);
+        if (nullptr == body) {
+            return nullptr;
+        }
+
+        DBusMessageIter iter, array_iter;
+        dbus_message_iter_init_append(body, &iter);
+        bool ok = dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &array_iter);
+        for (const auto& p : snapshot.int_properties) {
+            ok = ok && PropertyStorage::appendEntry(&array_iter, p.first.c_str(), DBUS_TYPE_INT32, &(p.second));
+        }
+        for (const auto& p : snapshot.string_properties) {
+            const char* str_ptr = p.second.c_str();
+            ok = ok && PropertyStorage::appendEntry(&array_iter, p.first.c_str(), DBUS_TYPE_STRING, &str_ptr);
+        }
+        ok = ok && dbus_message_iter_close_container(&iter, &array_iter);
+        if (false == ok) {
+            dbus_message_unref(body);
+            return nullptr;
+        }
+        return body;
+    }
+
+    // {sv}
+    static bool appendEntry(DBusMessageIter* array_iter, const char* name, int type, const void* value) {
+        const char signature[2] = { static_cast<char>(type), '\0' };
+        DBusMessageIter entry_iter, variant_iter;
+        return dbus_message_iter_open_container(array_iter, DBUS_TYPE_DICT_ENTRY, nullptr, &entry_iter)
+            && dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_STRING, &name)
+            && dbus_message_iter_open_container(&entry_iter, DBUS_TYPE_VARIANT, signature, &variant_iter)
+            && dbus_message_iter_append_basic(&variant_iter, type, value)
+            && dbus_message_iter_close_container(&entry_iter, &variant_iter)
+            && dbus_message_iter_close_container(array_iter, &entry_iter);
     }
 };
 
@@ -70,14 +996,48 @@ public:
 // Controller
 //
 
-class PropertyController : public IRouter {
+class PropertyController : public DBusRouter {
 private:
     PropertyStorage properties;
+    // Connection PropertiesChanged is emitted on
+    DBusConnection* conn;
+private:
+    // Changed since the last PropertiesChanged (values are read at emit time,
+    // so any number of Sets inside one window collapse into the latest value)
+    // Sets may run on worker threads, the emitter on the loop thread
+    mutable std::mutex dirty_mutex;
+    std::set<std::string, std::less<>> dirty;
+    std::chrono::milliseconds emit_window;
+    std::chrono::steady_clock::time_point last_emit;
 
 public:
     // Constructor
-    PropertyController() {}
+    // window: at most one PropertiesChanged per window
+    // snapshot_path: persist properties in this mapped file (nullptr = memory only)
+    // journal_path: write-ahead log for Sets (nullptr = none)
+    PropertyController(DBusConnection* dc,
+                       std::chrono::milliseconds window = std::chrono::milliseconds(50),
+                       const char* snapshot_path = nullptr,
+                       const char* journal_path = nullptr) :
+        properties(snapshot_path, journal_path),
+        conn(dc),
+        emit_window(window),
+        last_emit()
+    {
+        // Handle Get property request
+        this->addMethod("org.freedesktop.DBus.Properties", "Get",
+            [this] (DBusMessage* message, std::pmr::memory_resource* arena) {
+                return this->PropertyController::handleGetProperty(message, arena);
+            });
+        // Handle Set property request
+        this->addMethod("org.freedesktop.DBus.Properties", "Set",
+            [this] (DBusMessage* message) { return this->PropertyController::handleSetProperty(message); });
+        // Handle GetAll properties request
+        this->addMethod("org.freedesktop.DBus.Properties", "GetAll",
+            [this] (DBusMessage* message) { return this->PropertyController::handleGetAllProperties(message); });
+    }
     // delete
+    PropertyController() = delete;
     PropertyController(PropertyController&& other) = delete;
     PropertyController& operator=(PropertyController&& other) = delete;
     PropertyController(const PropertyController&) = delete;
@@ -86,38 +1046,70 @@ public:
     ~PropertyController() {}
 
 public:
-    DBusMessage* handleRequest(DBusMessage* message) override {
-        // Handle Get property request
-        if (true == dbus_message_is_method_call(message, "org.freedesktop.DBus.Properties", "Get")) {
-            return handleGetProperty(message);
+    //
+    // Coalesced PropertiesChanged (driven by the service loop)
+    //
+
+    // ms until pending changes may be emitted, -1 if nothing is pending
+    // (thread-safe)
+    int emitDelay() const {
+        std::lock_guard<std::mutex> lock(this->dirty_mutex);
+        return this->PropertyController::emitDelayLocked();
+    }
+
+    // Emit one PropertiesChanged for everything changed, if the window allows.
+    // A change after a quiet period goes out on the next wakeup; changes
+    // during the window wait for its end.
+    void emitPendingChanges() {
+        std::lock_guard<std::mutex> lock(this->dirty_mutex);
+        if (0 != this->PropertyController::emitDelayLocked()) {
+            return;
         }
-        // Handle Set property request
-        else if (true == dbus_message_is_method_call(message, "org.freedesktop.DBus.Properties", "Set")) {
-            return handleSetProperty(message);
+        this->PropertyController::emitPropertiesChanged();
+        this->dirty.clear();
+        this->last_emit = std::chrono::steady_clock::now();
+    }
+
+    // Called before a batch of replies is sent: Sets in it become durable
+    // together, so none of their replies goes out ahead of the journal.
+    // false if the journal could not be synced (the batch must not be acknowledged)
+    bool commitChanges() {
+        // Journaled Sets are announced once they are durable (and visible)
+        std::vector<std::string> changed;
+        const bool ok = properties.syncJournal(changed);
+        for (const std::string& name : changed) {
+            this->PropertyController::markDirty(name.c_str());
         }
-        // Handle GetAll properties request
-        else if (true == dbus_message_is_method_call(message, "org.freedesktop.DBus.Properties", "GetAll")) {
-            return handleGetAllProperties(message);
+        if (false == ok) {
+            Logger::error("ERROR: Journal sync failed, failing the batch's replies");
+            return false;
         }
-        else {
-            return dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_METHOD, "Method not found");
+        return true;
+    }
+
+private:
+    int emitDelayLocked() const {
+        if (this->dirty.empty()) {
+            return -1;
         }
+        const auto due = this->last_emit + this->emit_window;
+        const auto now = std::chrono::steady_clock::now();
+        if (due <= now) {
+            return 0;
+        }
+        // Round up so the loop never wakes before the window is over
+        return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(due - now).count());
     }
 
 private:
-    DBusMessage* handleGetProperty(DBusMessage* message) {
+    DBusMessage* handleGetProperty(DBusMessage* message, std::pmr::memory_resource* arena) {
         DBusError error;
         dbus_error_init(&error);
         
         const char* interface_name;
         const char* property_name;
         
-        if (!dbus_message_get_args(
-                message,
-                &error,
-                DBUS_TYPE_STRING, &interface_name,
-                DBUS_TYPE_STRING, &property_name,
-                DBUS_TYPE_INVALID)) {
+        if (!DBusArgs<const char*, const char*>::read(message, interface_name, property_name)) {
             DBusMessage* reply = dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Invalid arguments");
             dbus_error_free(&error);
             return reply;
@@ -129,7 +1121,7 @@ private:
         dbus_message_iter_init_append(reply, &iter);
 
         int32_t int_value;
-        std::string str_value;
+        std::pmr::string str_value(arena);
 
         if (properties.getIntProperty(property_name, int_value)) {
             dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT, "i", &variant_iter);
@@ -175,40 +1167,143 @@ private:
         dbus_message_iter_recurse(&iter, &variant_iter);
         variant_type = dbus_message_iter_get_arg_type(&variant_iter);
 
+        // Refuse up front what could not be made durable
+        size_t value_size = sizeof(int32_t);
+        if (variant_type == DBUS_TYPE_STRING) {
+            const char* value;
+            dbus_message_iter_get_basic(&variant_iter, &value);
+            value_size = std::strlen(value);
+        }
+        if (false == properties.accepts(property_name, value_size)) {
+            dbus_error_free(&error);
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Property name or value too long");
+        }
+
         if (variant_type == DBUS_TYPE_INT32) {
             int32_t value;
             dbus_message_iter_get_basic(&variant_iter, &value);
             if (properties.setIntProperty(property_name, value)) {
-                std::cout << "Property set: " << property_name << " = " << value << std::endl;
-                properties.listProperties();
+                Logger::info("Property set: ", property_name, " = ", value);
+                if (Logger::enabled(LogLevel::DEBUG)) {
+                    properties.listProperties();
+                }
+                if (false == properties.isJournaled()) {
+                    this->PropertyController::markDirty(property_name);
+                }
                 dbus_error_free(&error);
                 return dbus_message_new_method_return(message);
             }
+            dbus_error_free(&error);
+            return dbus_message_new_error(message, DBUS_ERROR_FAILED, "Unable to store property");
         }
         else if (variant_type == DBUS_TYPE_STRING) {
             const char* value;
             dbus_message_iter_get_basic(&variant_iter, &value);
             if (properties.setStringProperty(property_name, value)) {
-                std::cout << "Property set: " << property_name << " = " << value << std::endl;
-                properties.listProperties();
+                Logger::info("Property set: ", property_name, " = ", value);
+                if (Logger::enabled(LogLevel::DEBUG)) {
+                    properties.listProperties();
+                }
+                if (false == properties.isJournaled()) {
+                    this->PropertyController::markDirty(property_name);
+                }
                 dbus_error_free(&error);
                 return dbus_message_new_method_return(message);
             }
+            dbus_error_free(&error);
+            return dbus_message_new_error(message, DBUS_ERROR_FAILED, "Unable to store property");
         }
 
         dbus_error_free(&error);
         return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Unsupported property type");
     }
 
-    DBusMessage* handleGetAllProperties(DBusMessage* message) {
-        // For simplicity, this is a basic implementation
-        DBusMessage* reply = dbus_message_new_method_return(message);
-        DBusMessageIter iter, array_iter;
+    void markDirty(const char* property_name) {
+        std::lock_guard<std::mutex> lock(this->dirty_mutex);
+        // Transparent lookup: no string is built for an already dirty name
+        if (this->dirty.find(std::string_view(property_name)) == this->dirty.end()) {
+            this->dirty.emplace(property_name);
+        }
+    }
 
-        dbus_message_iter_init_append(reply, &iter);
-        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &array_iter);
-        dbus_message_iter_close_container(&iter, &array_iter);
+    // PropertiesChanged(s interface, a{sv} changed, as invalidated)
+    // One signal carries the current value of every dirty property
+    void emitPropertiesChanged() {
+        const char* interface_name = "com.example.PropertyInterface";
+
+        DBusMessage* signal = dbus_message_new_signal(
+            "/com/example/PropertyService",
+            "org.freedesktop.DBus.Properties",
+            "PropertiesChanged");
+        if (nullptr == signal) {
+            Logger::error("ERROR: Unable to allocate PropertiesChanged");
+            return;
+        }
+
+        DBusMessageIter iter, changed_iter, invalidated_iter;
+        dbus_message_iter_init_append(signal, &iter);
+        dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface_name);
+        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &changed_iter);
+        std::string names;
+        for (const std::string& name : this->dirty) {
+            DBusMessageIter entry_iter, variant_iter;
+            const char* property_name = name.c_str();
+            int32_t int_value;
+            std::string str_value;
+
+            if (properties.getIntProperty(name, int_value)) {
+                dbus_message_iter_open_container(&changed_iter, DBUS_TYPE_DICT_ENTRY, nullptr, &entry_iter);
+                dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_STRING, &property_name);
+                dbus_message_iter_open_container(&entry_iter, DBUS_TYPE_VARIANT, "i", &variant_iter);
+                dbus_message_iter_append_basic(&variant_iter, DBUS_TYPE_INT32, &int_value);
+                dbus_message_iter_close_container(&entry_iter, &variant_iter);
+                dbus_message_iter_close_container(&changed_iter, &entry_iter);
+            }
+            else if (properties.getStringProperty(name, str_value)) {
+                const char* str_ptr = str_value.c_str();
+                dbus_message_iter_open_container(&changed_iter, DBUS_TYPE_DICT_ENTRY, nullptr, &entry_iter);
+                dbus_message_iter_append_basic(&entry_iter, DBUS_TYPE_STRING, &property_name);
+                dbus_message_iter_open_container(&entry_iter, DBUS_TYPE_VARIANT, "s", &variant_iter);
+                dbus_message_iter_append_basic(&variant_iter, DBUS_TYPE_STRING, &str_ptr);
+                dbus_message_iter_close_container(&entry_iter, &variant_iter);
+                dbus_message_iter_close_container(&changed_iter, &entry_iter);
+            }
+            else {
+                continue;
+            }
+            names += " " + name;
+        }
+        Logger::info("PropertiesChanged:", names);
+        dbus_message_iter_close_container(&iter, &changed_iter);
+        dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "s", &invalidated_iter);
+        dbus_message_iter_close_container(&iter, &invalidated_iter);
+
+        dbus_connection_send(this->conn, signal, nullptr);
+        dbus_message_unref(signal);
+        dbus_connection_flush(this->conn);
+    }
 
+    DBusMessage* handleGetAllProperties(DBusMessage* message) {
+        const char* interface_name;
+        if (!DBusArgs<const char*>::read(message, interface_name)) {
+            return dbus_message_new_error(message, DBUS_ERROR_INVALID_ARGS, "Invalid arguments");
+        }
+        // "" means all interfaces; we only have one
+        if (interface_name[0] != '\0' && std::strcmp(interface_name, "com.example.PropertyInterface") != 0) {
+            return dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_INTERFACE, "Unknown interface");
+        }
+
+        // Copy the bytes marshalled by the last writer and address them to this caller
+        DBusMessage* reply = properties.copyGetAll();
+        if ( nullptr == reply
+            || false == dbus_message_set_reply_serial(reply, dbus_message_get_serial(message))
+            || false == dbus_message_set_destination(reply, dbus_message_get_sender(message)) ) {
+            if (reply) {
+                dbus_message_unref(reply);
+            }
+            return dbus_message_new_error(message, DBUS_ERROR_NO_MEMORY, "Unable to build reply");
+        }
+        dbus_message_set_no_reply(reply, TRUE);
         return reply;
     }
 };
@@ -218,9 +1313,12 @@ private:
 //
 
 class PropertyService : public DBusServer {
+private:
+    PropertyController* properties;
+
 public:
     PropertyService(DBusConnection* dc, PropertyController* ctl) 
-        : DBusServer(dc, "com.example.PropertyService", ctl) {}
+        : DBusServer(dc, "com.example.PropertyService", ctl), properties(ctl) {}
 
     void run() override {
         std::cout << "Property Service started..." << std::endl;
@@ -229,7 +1327,25 @@ public:
         std::cout << "Interface: org.freedesktop.DBus.Properties" << std::endl;
         std::cout << std::endl;
 
+#if defined(WORKER_POOL)
+        // Get / GetAll scale across workers (lock-free storage reads)
+        DBusServer::runWorkerPool();
+#else
         DBusServer::run();
+#endif
+    }
+
+protected:
+    // Sleep no longer than the pending PropertiesChanged window
+    int waitTimeout() override {
+        return properties->emitDelay();
+    }
+    void onWakeup() override {
+        properties->emitPendingChanges();
+    }
+    // One journal flush per batch of replies; a failed flush fails the batch
+    bool onBatchEnd() override {
+        return properties->commitChanges();
     }
 };
 
@@ -252,7 +1368,10 @@ int main() {
     }
 
     // Create controller and service
-    PropertyController controller;
+    // (PROPERTY_SNAPSHOT_FILE=<path> keeps the values across restarts,
+    //  PROPERTY_JOURNAL_FILE=<path> makes every acknowledged Set durable)
+    PropertyController controller(connection, std::chrono::milliseconds(50),
+        std::getenv("PROPERTY_SNAPSHOT_FILE"), std::getenv("PROPERTY_JOURNAL_FILE"));
     PropertyService service(connection, &controller);
 
     // Run service
@@ -1,24 +1,253 @@
+#include <algorithm>
 #include <atomic>
 #include <csignal>
 #include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
 
 #include "../include/dbus_conn_wrapper.hpp"
+#include "../include/dbus_args.hpp"
+#include "../include/dbus_event_loop.hpp"
+#include "../include/dbus_logger.hpp"
+#include "../include/dbus_ring_buffer.hpp"
 
 namespace {
 constexpr const char* kInterfaceName = "com.example.SignalInterface";
 constexpr const char* kSignalName = "Tick";
 
-std::atomic<bool> running{true};
+DBusEventLoop* activeLoop = nullptr;
+bool quiet = false;
+// Simulated handler cost, to show what a slow handler does to each mode
+unsigned int handlerDelayUs = 0;
+
+// Ring mode: the loop thread only queues, the consumer thread handles
+struct Received {
+    DBusMessage* message = nullptr;
+    uint64_t recvNs = 0;
+};
+std::unique_ptr<RingBuffer<Received>> ring;
 
 void handleSignal(int) {
-    running.store(false);
+    // stop() only writes to an eventfd, safe inside a signal handler
+    if (activeLoop != nullptr) {
+        activeLoop->stop();
+    }
 }
+
+// Latency histogram (same layout as the router's): bucket 0: < 1us,
+// bucket i: [2^(i-1), 2^i) us, last bucket: everything above
+constexpr size_t kLatencyBuckets = 24;
+
+// Per object path (one path per service stream)
+struct StreamStats {
+    uint32_t lastCounter = 0;
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    uint64_t restarts = 0;
+    // Delivery latency (only Ticks carrying a send timestamp); fixed size,
+    // however long the client runs
+    uint64_t latencyBuckets[kLatencyBuckets] = {};
+    uint64_t latencySamples = 0;
+    uint64_t latencyMaxNs = 0;
+};
+
+// Transparent comparator: per-tick lookups by const char* build no string
+std::map<std::string, StreamStats, std::less<>> streams;
+
+uint64_t monotonicNs() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
 }
 
-int main() {
-    std::signal(SIGINT, handleSignal);
-    std::signal(SIGTERM, handleSignal);
+void recordLatency(StreamStats& stats, uint64_t latencyNs) {
+    // log2 of whole microseconds
+    size_t bucket = 0;
+    for (uint64_t us = latencyNs / 1000; us > 0 && bucket < kLatencyBuckets - 1; us >>= 1) {
+        ++bucket;
+    }
+    ++stats.latencyBuckets[bucket];
+    ++stats.latencySamples;
+    stats.latencyMaxNs = std::max(stats.latencyMaxNs, latencyNs);
+}
+
+// Nearest-rank percentile in us, as the upper edge of the bucket holding it
+// (at most 2x above the true value; never above the largest sample)
+double percentile(const StreamStats& stats, double p) {
+    if (0 == stats.latencySamples) {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(stats.latencySamples) + 0.999999);
+    rank = std::min(std::max<uint64_t>(rank, 1), stats.latencySamples);
+
+    uint64_t seen = 0;
+    size_t bucket = 0;
+    for (; bucket < kLatencyBuckets - 1; ++bucket) {
+        seen += stats.latencyBuckets[bucket];
+        if (seen >= rank) {
+            break;
+        }
+    }
+    const double maxUs = static_cast<double>(stats.latencyMaxNs) / 1000.0;
+    if (bucket == kLatencyBuckets - 1) {
+        return maxUs;
+    }
+    return std::min(static_cast<double>(uint64_t(1) << bucket), maxUs);
+}
+
+void trackCounter(const char* path, StreamStats& stats, uint32_t counter) {
+    if (stats.received > 0) {
+        if (counter > stats.lastCounter + 1) {
+            const uint32_t gap = counter - stats.lastCounter - 1;
+            stats.lost += gap;
+            Logger::info("[GAP] path=", path, " expected=", stats.lastCounter + 1, " got=", counter, " lost=", gap);
+        } else if (counter <= stats.lastCounter) {
+            // The bus keeps per-sender order, so going back means a new service instance
+            ++stats.restarts;
+            Logger::info("[RESTART] path=", path, " counter=", counter);
+        }
+    }
+    stats.lastCounter = counter;
+    ++stats.received;
+}
+
+void handleTick(DBusMessage* message, uint64_t recvNs) {
+    const char* path = dbus_message_get_path(message);
+    uint32_t counter = 0;
+    const char* text = "";
+    uint64_t sendNs = 0;
+
+    // The send timestamp is optional: older services only send (counter, text)
+    bool stamped = DBusArgs<uint32_t, const char*, uint64_t>::read(message, counter, text, sendNs);
+    if (!stamped && !DBusArgs<uint32_t, const char*>::read(message, counter, text)) {
+        Logger::error("Parse signal error: unexpected signature ", dbus_message_get_signature(message));
+        return;
+    }
+
+    // Signals always carry an object path
+    auto it = streams.find(std::string_view(path));
+    if (it == streams.end()) {
+        it = streams.emplace(path, StreamStats()).first;
+    }
+    StreamStats& stats = it->second;
+    trackCounter(path, stats, counter);
+    if (stamped && recvNs >= sendNs) {
+        recordLatency(stats, recvNs - sendNs);
+    }
+
+    if (!quiet) {
+        if (stamped) {
+            Logger::info("[RECV] Tick path=", path, " counter=", counter, ", text=", text,
+                         ", latency=", (recvNs - sendNs) / 1000, " us");
+        } else {
+            Logger::info("[RECV] Tick path=", path, " counter=", counter, ", text=", text);
+        }
+    }
+    if (handlerDelayUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(handlerDelayUs));
+    }
+}
+
+DBusHandlerResult onMessage(DBusConnection* /*conn*/, DBusMessage* message, void* /*data*/) {
+    if (!dbus_message_is_signal(message, kInterfaceName, kSignalName)) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+
+    const uint64_t recvNs = monotonicNs();
+    if (ring) {
+        // Keep the message alive until the consumer is done with it
+        dbus_message_ref(message);
+        ring->push(Received{message, recvNs});
+    } else {
+        handleTick(message, recvNs);
+    }
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+void consume() {
+    Received item;
+    while (ring->pop(item)) {
+        handleTick(item.message, item.recvNs);
+        dbus_message_unref(item.message);
+    }
+}
+
+bool parseOverflow(const std::string& name, RingOverflow& overflow) {
+    if (name == "drop-oldest") {
+        overflow = RingOverflow::DROP_OLDEST;
+    } else if (name == "drop-newest") {
+        overflow = RingOverflow::DROP_NEWEST;
+    } else if (name == "block") {
+        overflow = RingOverflow::BLOCK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void printSummary() {
+    std::cout << "Summary" << std::endl;
+    for (auto& entry : streams) {
+        StreamStats& stats = entry.second;
+        const uint64_t expected = stats.received + stats.lost;
+        const double lossRate = expected > 0 ? 100.0 * static_cast<double>(stats.lost) / static_cast<double>(expected) : 0.0;
+
+        std::cout << "  " << entry.first << ": received=" << stats.received << ", lost=" << stats.lost
+                  << " (" << lossRate << "%)";
+        if (stats.restarts > 0) {
+            std::cout << ", restarts=" << stats.restarts;
+        }
+        std::cout << std::endl;
+
+        if (stats.latencySamples > 0) {
+            std::cout << "    latency us: p50<=" << percentile(stats, 50.0)
+                      << ", p99<=" << percentile(stats, 99.0)
+                      << ", p99.9<=" << percentile(stats, 99.9)
+                      << ", max=" << static_cast<double>(stats.latencyMaxNs) / 1000.0
+                      << " (" << stats.latencySamples << " samples)" << std::endl;
+        }
+    }
+}
+}
+
+int main(int argc, char* argv[]) {
+    bool useRing = false;
+    size_t capacity = 1024;
+    RingOverflow overflow = RingOverflow::DROP_OLDEST;
+    std::string overflowName = "drop-oldest";
+    const char* usage = "Usage: ./signal_client [-q|--quiet] [--ring] [--capacity=N]"
+                        " [--overflow=drop-oldest|drop-newest|block] [--handler-delay-us=N]";
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        try {
+            if (arg == "-q" || arg == "--quiet") {
+                quiet = true;
+            } else if (arg == "--ring") {
+                useRing = true;
+            } else if (arg.rfind("--capacity=", 0) == 0) {
+                capacity = std::stoul(arg.substr(11));
+            } else if (arg.rfind("--overflow=", 0) == 0) {
+                overflowName = arg.substr(11);
+                if (!parseOverflow(overflowName, overflow)) {
+                    throw std::invalid_argument(arg);
+                }
+            } else if (arg.rfind("--handler-delay-us=", 0) == 0) {
+                handlerDelayUs = static_cast<unsigned int>(std::stoul(arg.substr(19)));
+            } else {
+                throw std::invalid_argument(arg);
+            }
+        } catch (...) {
+            std::cerr << usage << std::endl;
+            return 1;
+        }
+    }
 
     DBusConn dbusConn(DBUS_BUS_SESSION);
     DBusConnection* conn = dbusConn.getConn();
@@ -39,41 +268,54 @@ int main() {
         return 1;
     }
 
+    // Woken only by socket readiness; no polling interval
+    DBusEventLoop loop;
+    if (!dbus_connection_add_filter(conn, onMessage, nullptr, nullptr) || !loop.addConnection(conn)) {
+        std::cerr << "Unable to attach connection to event loop" << std::endl;
+        dbus_error_free(&error);
+        return 1;
+    }
+
+    activeLoop = &loop;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
     std::cout << "Listening signal" << std::endl;
     std::cout << "Interface: " << kInterfaceName << std::endl;
     std::cout << "Signal: " << kSignalName << std::endl;
     std::cout << "Press Ctrl+C to stop" << std::endl;
 
-    while (running.load()) {
-        dbus_connection_read_write(conn, 1000);
+    std::thread consumer;
+    if (useRing) {
+        ring.reset(new RingBuffer<Received>(capacity, overflow,
+            [] (Received& dropped) { dbus_message_unref(dropped.message); }));
+        consumer = std::thread(consume);
+        std::cout << "Ring: capacity=" << ring->capacity() << ", overflow=" << overflowName << std::endl;
+    }
 
-        DBusMessage* message = dbus_connection_pop_message(conn);
-        if (message == nullptr) {
-            continue;
-        }
+    loop.run();
 
-        if (dbus_message_is_signal(message, kInterfaceName, kSignalName)) {
-            uint32_t counter = 0;
-            const char* text = "";
-
-            if (dbus_message_get_args(message,
-                                      &error,
-                                      DBUS_TYPE_UINT32,
-                                      &counter,
-                                      DBUS_TYPE_STRING,
-                                      &text,
-                                      DBUS_TYPE_INVALID)) {
-                std::cout << "[RECV] Tick counter=" << counter << ", text=" << text << std::endl;
-            } else {
-                std::cerr << "Parse signal error: " << error.message << std::endl;
-                dbus_error_free(&error);
-                dbus_error_init(&error);
-            }
-        }
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    activeLoop = nullptr;
 
-        dbus_message_unref(message);
+    loop.removeConnection(conn);
+    dbus_connection_remove_filter(conn, onMessage, nullptr);
+
+    // Let the consumer finish what is queued
+    uint64_t ringDropped = 0;
+    if (ring) {
+        ring->close();
+        consumer.join();
+        ringDropped = ring->dropped();
+        ring.reset();
     }
 
+    Logger::flush();
+    printSummary();
+    if (useRing) {
+        std::cout << "  ring dropped=" << ringDropped << std::endl;
+    }
     dbus_error_free(&error);
     std::cout << "Signal client stopped" << std::endl;
     return 0;
@@ -1,11 +1,15 @@
 #include <atomic>
-#include <chrono>
+#include <cerrno>
 #include <csignal>
 #include <cstdint>
+#include <ctime>
 #include <iostream>
-#include <thread>
+#include <string>
+#include <vector>
 
 #include "../include/dbus_conn_wrapper.hpp"
+#include "../include/dbus_args.hpp"
+#include "../include/dbus_logger.hpp"
 
 namespace {
 constexpr const char* kServiceName = "com.example.SignalService";
@@ -13,26 +17,141 @@ constexpr const char* kObjectPath = "/com/example/SignalService";
 constexpr const char* kInterfaceName = "com.example.SignalInterface";
 constexpr const char* kSignalName = "Tick";
 
+// Streams faster than this log every tick at debug level only and are
+// summarized once per second instead (keeps the output volume readable)
+constexpr uint64_t kLogEveryTickNs = 10ULL * 1000 * 1000;
+constexpr uint64_t kReportIntervalNs = 1000ULL * 1000 * 1000;
+
 std::atomic<bool> running{true};
 
 void handleSignal(int) {
     running.store(false);
 }
+
+struct Stream {
+    std::string path;
+    uint64_t periodNs;
+    uint64_t deadlineNs;
+    uint32_t counter;
+    uint64_t emitted;
+    uint64_t missed;
+    uint64_t reportedEmitted;
+    uint64_t reportedMissed;
+};
+
+uint64_t monotonicNs() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+// Sleep until an absolute CLOCK_MONOTONIC time, so the cost of the work done
+// between two ticks never shifts the next one. false if interrupted by a stop.
+bool sleepUntil(uint64_t deadlineNs) {
+    timespec deadline{};
+    deadline.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ULL);
+    deadline.tv_nsec = static_cast<long>(deadlineNs % 1000000000ULL);
+    while (running.load()) {
+        const int rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        if (rc == 0) {
+            return true;
+        }
+        if (rc != EINTR) {
+            std::cerr << "clock_nanosleep failed: " << rc << std::endl;
+            return false;
+        }
+    }
+    return false;
+}
+
+// "500" / "500ms" -> milliseconds, "250us" -> microseconds
+bool parsePeriod(const std::string& arg, uint64_t& periodNs) {
+    size_t pos = 0;
+    unsigned long long value = 0;
+    try {
+        value = std::stoull(arg, &pos);
+    } catch (...) {
+        return false;
+    }
+
+    const std::string unit = arg.substr(pos);
+    if (unit.empty() || unit == "ms") {
+        periodNs = value * 1000ULL * 1000ULL;
+    } else if (unit == "us") {
+        periodNs = value * 1000ULL;
+    } else {
+        return false;
+    }
+    return periodNs > 0;
+}
+
+std::string formatPeriod(uint64_t periodNs) {
+    if (periodNs % 1000000ULL == 0) {
+        return std::to_string(periodNs / 1000000ULL) + " ms";
+    }
+    return std::to_string(periodNs / 1000ULL) + " us";
+}
+
+bool emitTick(DBusConnection* conn, Stream& stream) {
+    DBusMessage* signalMessage = dbus_message_new_signal(stream.path.c_str(), kInterfaceName, kSignalName);
+    if (signalMessage == nullptr) {
+        Logger::error("Failed to allocate signal message");
+        return false;
+    }
+
+    // Send time on CLOCK_MONOTONIC (same clock on every local process), used
+    // by subscribers to measure delivery latency
+    const char* text = "periodic tick";
+    const uint64_t sendNs = monotonicNs();
+    if (!DBusArgs<uint32_t, const char*, uint64_t>::append(signalMessage, stream.counter, text, sendNs)) {
+        Logger::error("Failed to append signal arguments");
+        dbus_message_unref(signalMessage);
+        return false;
+    }
+
+    if (!dbus_connection_send(conn, signalMessage, nullptr)) {
+        Logger::error("Failed to send signal");
+        dbus_message_unref(signalMessage);
+        return false;
+    }
+    dbus_message_unref(signalMessage);
+    return true;
+}
+
+void reportStreams(std::vector<Stream>& streams, double elapsedSec) {
+    for (size_t i = 0; i < streams.size(); ++i) {
+        Stream& stream = streams[i];
+        const uint64_t emitted = stream.emitted - stream.reportedEmitted;
+        const uint64_t missed = stream.missed - stream.reportedMissed;
+        if (stream.periodNs >= kLogEveryTickNs && missed == 0) {
+            continue;
+        }
+        Logger::info("[RATE] stream=", i, " path=", stream.path, " emitted=", emitted,
+                     " (", static_cast<uint64_t>(emitted / elapsedSec), "/s) missed=", missed);
+        stream.reportedEmitted = stream.emitted;
+        stream.reportedMissed = stream.missed;
+    }
+}
 }
 
 int main(int argc, char* argv[]) {
-    unsigned int periodMs = 1000;
-    if (argc > 1) {
-        try {
-            periodMs = static_cast<unsigned int>(std::stoul(argv[1]));
-            if (periodMs == 0U) {
-                std::cerr << "Period must be greater than 0 ms" << std::endl;
-                return 1;
-            }
-        } catch (...) {
-            std::cerr << "Invalid period. Usage: ./signal_service [period_ms]" << std::endl;
+    // One stream per period argument; the first one keeps the historic path
+    std::vector<Stream> streams;
+    for (int i = 1; i < argc; ++i) {
+        uint64_t periodNs = 0;
+        if (!parsePeriod(argv[i], periodNs)) {
+            std::cerr << "Invalid period: " << argv[i] << std::endl;
+            std::cerr << "Usage: ./signal_service [period[ms|us]]..." << std::endl;
             return 1;
         }
+        std::string path = kObjectPath;
+        if (!streams.empty()) {
+            path += "/" + std::to_string(streams.size());
+        }
+        streams.push_back(Stream{path, periodNs, 0, 0, 0, 0, 0, 0});
+    }
+    if (streams.empty()) {
+        streams.push_back(Stream{kObjectPath, 1000ULL * 1000 * 1000, 0, 0, 0, 0, 0, 0});
     }
 
     std::signal(SIGINT, handleSignal);
@@ -60,46 +179,72 @@ int main(int argc, char* argv[]) {
 
     std::cout << "Signal service started" << std::endl;
     std::cout << "Service: " << kServiceName << std::endl;
-    std::cout << "Object Path: " << kObjectPath << std::endl;
     std::cout << "Interface: " << kInterfaceName << std::endl;
     std::cout << "Signal: " << kSignalName << std::endl;
-    std::cout << "Period: " << periodMs << " ms" << std::endl;
-
-    uint32_t counter = 0;
-    while (running.load()) {
-        ++counter;
+    for (const Stream& stream : streams) {
+        std::cout << "Object Path: " << stream.path << ", Period: " << formatPeriod(stream.periodNs) << std::endl;
+    }
 
-        DBusMessage* signalMessage = dbus_message_new_signal(kObjectPath, kInterfaceName, kSignalName);
-        if (signalMessage == nullptr) {
-            std::cerr << "Failed to allocate signal message" << std::endl;
-            break;
+    // All streams share one time base; deadlines are absolute, so the next
+    // tick is always start + n * period no matter how long sending took
+    const uint64_t startNs = monotonicNs();
+    for (Stream& stream : streams) {
+        stream.deadlineNs = startNs;
+    }
+    uint64_t lastReportNs = startNs;
+
+    bool ok = true;
+    while (ok && running.load()) {
+        uint64_t nextNs = streams.front().deadlineNs;
+        for (const Stream& stream : streams) {
+            if (stream.deadlineNs < nextNs) {
+                nextNs = stream.deadlineNs;
+            }
         }
-
-        const char* text = "periodic tick";
-        if (!dbus_message_append_args(signalMessage,
-                                      DBUS_TYPE_UINT32,
-                                      &counter,
-                                      DBUS_TYPE_STRING,
-                                      &text,
-                                      DBUS_TYPE_INVALID)) {
-            std::cerr << "Failed to append signal arguments" << std::endl;
-            dbus_message_unref(signalMessage);
+        if (!sleepUntil(nextNs)) {
             break;
         }
 
-        if (!dbus_connection_send(conn, signalMessage, nullptr)) {
-            std::cerr << "Failed to send signal" << std::endl;
-            dbus_message_unref(signalMessage);
-            break;
+        const uint64_t nowNs = monotonicNs();
+        for (Stream& stream : streams) {
+            if (stream.deadlineNs > nowNs) {
+                continue;
+            }
+
+            ++stream.counter;
+            ++stream.emitted;
+            if (!emitTick(conn, stream)) {
+                ok = false;
+                break;
+            }
+            Logger::log(stream.periodNs >= kLogEveryTickNs ? LogLevel::INFO : LogLevel::DEBUG,
+                        "[EMIT] Tick path=", stream.path, " counter=", stream.counter);
+
+            // Late by more than a period: skip the missed slots instead of
+            // bursting to catch up, and keep the original phase
+            const uint64_t late = (nowNs - stream.deadlineNs) / stream.periodNs;
+            if (late > 0) {
+                stream.missed += late;
+                Logger::log(stream.periodNs >= kLogEveryTickNs ? LogLevel::INFO : LogLevel::DEBUG,
+                            "[MISS] path=", stream.path, " skipped=", late);
+            }
+            stream.deadlineNs += (late + 1) * stream.periodNs;
         }
+        // One flush per wake-up, shared by every stream that fired
         dbus_connection_flush(conn);
-        dbus_message_unref(signalMessage);
 
-        std::cout << "[EMIT] Tick counter=" << counter << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(periodMs));
+        if (nowNs - lastReportNs >= kReportIntervalNs) {
+            reportStreams(streams, static_cast<double>(nowNs - lastReportNs) / 1e9);
+            lastReportNs = nowNs;
+        }
     }
 
+    Logger::flush();
+    for (size_t i = 0; i < streams.size(); ++i) {
+        std::cout << "Stream " << i << " (" << streams[i].path << "): emitted=" << streams[i].emitted
+                  << ", missed=" << streams[i].missed << std::endl;
+    }
     std::cout << "Signal service stopped" << std::endl;
     dbus_error_free(&error);
-    return 0;
+    return ok ? 0 : 1;
 }